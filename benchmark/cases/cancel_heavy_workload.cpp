@@ -5,12 +5,14 @@
 #include "../utils/workload.hpp"
 #include <lob/order_book.hpp>
 
+#include <chrono>
+
 using namespace bench;
 
 // Realistic exchange workload: 93% cancel, 5% add, 2% modify.
 // Real exchange traffic is dominated by cancellations — most orders are
 // cancelled before execution. This benchmark reflects that pattern.
-static void BM_CancelHeavyWorkload(benchmark::State& state) {
+static void run_cancel_heavy(benchmark::State& state, int levels, int orders_per_level, const char* name) {
     warmup();
     const auto& w = workload();
     std::vector<double> latencies;
@@ -18,7 +20,7 @@ static void BM_CancelHeavyWorkload(benchmark::State& state) {
 
     for (auto _ : state) {
         state.PauseTiming();
-        PrePopulatedBook prepop(50, 10);
+        PrePopulatedBook prepop(levels, orders_per_level);
         auto& book = prepop.book();
         const auto& ids = prepop.ids();
         std::vector<lob::OrderId> active_ids(ids);
@@ -73,7 +75,7 @@ static void BM_CancelHeavyWorkload(benchmark::State& state) {
         stats.report(state);
         state.counters["Throughput_ops_sec"] = stats.throughput;
 
-        if (csv()) csv()->write("CancelHeavyWorkload", stats);
+        if (csv()) csv()->write(name, stats);
 
         idx += BENCHMARK_SAMPLES;
     }
@@ -82,4 +84,106 @@ static void BM_CancelHeavyWorkload(benchmark::State& state) {
     state.SetLabel("93% cancel, 5% add, 2% modify");
 }
 
+static void BM_CancelHeavyWorkload(benchmark::State& state) {
+    run_cancel_heavy(state, 50, 10, "CancelHeavyWorkload");
+}
+
+// Same mix against 100k resting orders. The small book drains within the
+// first few hundred cancels, so the run mostly cancels into a near-empty
+// order index; here the index stays large enough to miss in cache and the
+// cost of each lookup and erase shows.
+static void BM_CancelHeavyWorkloadDeep(benchmark::State& state) {
+    run_cancel_heavy(state, 500, 100, "CancelHeavyWorkloadDeep");
+    state.counters["Resting"] = 100000;
+}
+
+// Same mix fed through OrderBook::apply_batch in batches of kBatch, so the
+// index slot, order and level of upcoming cancels are prefetched while the
+// current command runs. Latency samples are per-batch time / batch size.
+static void BM_CancelHeavyWorkloadBatched(benchmark::State& state) {
+    constexpr size_t kBatch = 64;
+    warmup();
+    const auto& w = workload();
+    std::vector<double> latencies;
+    latencies.reserve(BENCHMARK_SAMPLES / kBatch + 1);
+
+    struct ActiveSink {
+        std::vector<lob::OrderId>* active_ids;
+        const std::vector<lob::BookCommand>* commands;
+
+        void on_fill(const lob::Fill&) noexcept {}
+        void on_result(size_t index, const lob::OrderBook::AddSummary& result) {
+            if ((*commands)[index].action == lob::BookAction::ADD && result.remaining_quantity > 0) {
+                active_ids->push_back(result.order_id);
+            }
+        }
+    };
+
+    std::vector<lob::BookCommand> commands;
+    commands.reserve(kBatch);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        PrePopulatedBook prepop(50, 10);
+        auto& book = prepop.book();
+        std::vector<lob::OrderId> active_ids(prepop.ids());
+        ActiveSink sink{&active_ids, &commands};
+        latencies.clear();
+        size_t idx = 0;
+        state.ResumeTiming();
+
+        auto batch_start = std::chrono::high_resolution_clock::now();
+
+        for (size_t base = 0; base < BENCHMARK_SAMPLES; base += kBatch) {
+            const size_t end_i = std::min(BENCHMARK_SAMPLES, base + kBatch);
+            auto start = std::chrono::high_resolution_clock::now();
+
+            commands.clear();
+            for (size_t i = base; i < end_i; ++i) {
+                int op = (idx + i) % 100;
+                if (op < 93) {
+                    if (!active_ids.empty()) {
+                        size_t cancel_idx = w.cancel_index(i) % active_ids.size();
+                        commands.push_back({lob::BookAction::CANCEL, lob::Side::BUY, lob::OrderType::LIMIT,
+                                            active_ids[cancel_idx], 0, 0});
+                        active_ids[cancel_idx] = active_ids.back();
+                        active_ids.pop_back();
+                    }
+                } else if (op < 98) {
+                    const auto& order = w.get(idx + i);
+                    commands.push_back({lob::BookAction::ADD, order.side, lob::OrderType::LIMIT, 0,
+                                        order.price, order.quantity});
+                } else if (!active_ids.empty()) {
+                    size_t mod_idx = (idx + i) % active_ids.size();
+                    commands.push_back({lob::BookAction::MODIFY, lob::Side::BUY, lob::OrderType::LIMIT,
+                                        active_ids[mod_idx], 0, w.modify_quantity(i)});
+                }
+            }
+            book.apply_batch(commands.data(), commands.size(), sink);
+
+            auto end = std::chrono::high_resolution_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count() /
+                                static_cast<double>(end_i - base));
+            benchmark::ClobberMemory();
+        }
+
+        auto batch_end = std::chrono::high_resolution_clock::now();
+        double batch_time_sec = std::chrono::duration<double>(batch_end - batch_start).count();
+
+        auto stats = Stats::compute(latencies);
+        stats.throughput = BENCHMARK_SAMPLES / batch_time_sec;
+        stats.report(state);
+        state.counters["Throughput_ops_sec"] = stats.throughput;
+
+        if (csv()) csv()->write("CancelHeavyWorkloadBatched", stats);
+
+        idx += BENCHMARK_SAMPLES;
+    }
+
+    state.SetItemsProcessed(state.iterations() * BENCHMARK_SAMPLES);
+    state.SetLabel("93% cancel, 5% add, 2% modify, batches of 64");
+}
+
 BENCHMARK(BM_CancelHeavyWorkload)->Unit(benchmark::kNanosecond)->MinTime(5.0);
+BENCHMARK(BM_CancelHeavyWorkloadDeep)->Unit(benchmark::kNanosecond)->MinTime(5.0);
+BENCHMARK(BM_CancelHeavyWorkloadBatched)->Unit(benchmark::kNanosecond)->MinTime(5.0);
@@ -1,7 +1,11 @@
+#include "../utils/perf_counter.hpp"
 #include "../utils/runner.hpp"
 #include "../utils/workload.hpp"
 #include <lob/order_book.hpp>
 
+#include <algorithm>
+#include <random>
+
 using namespace bench;
 
 static void BM_CancelOrder(benchmark::State& state) {
@@ -22,4 +26,100 @@ static void BM_CancelOrder(benchmark::State& state) {
         });
 }
 
+// Same book shape, orders rested handle-only and cancelled by OrderHandle:
+// resolution is a bounds + generation check with no hash probe.
+static void BM_CancelOrderHandle(benchmark::State& state) {
+    std::unique_ptr<PrePopulatedBook> prepop;
+    const std::vector<lob::OrderHandle>* handles = nullptr;
+
+    BenchmarkRunner runner(state, "CancelOrderHandle");
+    runner.run_with_setup(
+        [&] {
+            prepop = std::make_unique<PrePopulatedBook>(500, 10, true);
+            handles = &prepop->handles();
+        },
+        [&](size_t i) {
+            if (i < handles->size()) {
+                return prepop->book().cancel_order((*handles)[i]);
+            }
+            return false;
+        });
+}
+
+namespace {
+
+// 256k resting orders: well past L2 with pooled 80-byte nodes.
+struct DeepBookPolicy : lob::DefaultBookPolicy {
+    static constexpr std::size_t kOrderCapacity = 1u << 19;
+};
+
+struct DeepCompactBookPolicy : DeepBookPolicy {
+    static constexpr bool kCompactOrders = true;
+};
+
+// Same book on huge pages (explicit, else transparent), pre-faulted.
+struct DeepHugePageBookPolicy : DeepBookPolicy {
+    static constexpr lob::PageOptions kPageOptions{true, false, true};
+};
+
+template <typename Policy>
+void deep_book_cancel(benchmark::State& state, const char* name) {
+    constexpr int kLevels = 256;
+    constexpr int kOrdersPerLevel = 512;
+    std::unique_ptr<lob::BasicOrderBook<Policy>> book;
+    std::vector<lob::OrderId> ids;
+    TlbMissCounter tlb_misses;
+
+    BenchmarkRunner runner(state, name);
+    runner.run_with_setup(
+        [&] {
+            tlb_misses.stop();
+            book.reset();
+            book = std::make_unique<lob::BasicOrderBook<Policy>>();
+            ids.clear();
+            for (int j = 0; j < kOrdersPerLevel; ++j) {
+                for (int i = 1; i <= kLevels; ++i) {
+                    ids.push_back(book->add_order(BASE_PRICE - i * TICK_SIZE, 100, lob::Side::BUY).order_id);
+                    ids.push_back(book->add_order(BASE_PRICE + i * TICK_SIZE, 100, lob::Side::SELL).order_id);
+                }
+            }
+            std::shuffle(ids.begin(), ids.end(), std::mt19937_64(42));
+            runner.add_counter("HugePageCoverage", lob::page_stats().huge_coverage());
+            tlb_misses.start();
+        },
+        [&](size_t i) {
+            if (i < ids.size()) {
+                return book->cancel_order(ids[i]);
+            }
+            return false;
+        });
+    tlb_misses.stop();
+    if (tlb_misses.available()) {
+        runner.add_counter(
+            "dTLBMissesPerOp",
+            static_cast<double>(tlb_misses.count()) / static_cast<double>(state.iterations() * BENCHMARK_SAMPLES));
+    }
+}
+
+}  // namespace
+
+// Random cancels in a book far larger than cache, pooled vs compact orders.
+static void BM_CancelOrderDeepBook(benchmark::State& state) {
+    deep_book_cancel<DeepBookPolicy>(state, "CancelOrderDeepBook");
+}
+
+static void BM_CancelOrderDeepBookCompact(benchmark::State& state) {
+    deep_book_cancel<DeepCompactBookPolicy>(state, "CancelOrderDeepBookCompact");
+}
+
+// Pooled orders on huge pages: compare dTLBMissesPerOp (where the PMU is
+// readable) and latency with BM_CancelOrderDeepBook.
+static void BM_CancelOrderDeepBookHugePages(benchmark::State& state) {
+    deep_book_cancel<DeepHugePageBookPolicy>(state, "CancelOrderDeepBookHugePages");
+}
+
 BENCHMARK(BM_CancelOrder)->Unit(benchmark::kNanosecond)->MinTime(3.0);
+BENCHMARK(BM_CancelOrderHandle)->Unit(benchmark::kNanosecond)->MinTime(3.0);
+BENCHMARK(BM_CancelOrderDeepBook)->Unit(benchmark::kNanosecond)->MinTime(1.0);
+BENCHMARK(BM_CancelOrderDeepBookCompact)->Unit(benchmark::kNanosecond)->MinTime(1.0);
+BENCHMARK(BM_CancelOrderDeepBookHugePages)->Unit(benchmark::kNanosecond)->MinTime(1.0);
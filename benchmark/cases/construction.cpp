@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+#include <lob/book_registry.hpp>
+#include <lob/engine/sharded_engine.hpp>
+#include <lob/order_book.hpp>
+
+#include <memory>
+
+// Start-up cost: pools hand out slots lazily, so construction no longer
+// walks (and faults in) every reserved slot. The Prefaulted variants pay
+// for touching the reserved pages up front instead.
+
+static void BM_ConstructOrderBook(benchmark::State& state) {
+    const bool prefault = state.range(0) != 0;
+    for (auto _ : state) {
+        auto book = std::make_unique<lob::OrderBook>();
+        if (prefault) {
+            book->prefault();
+        }
+        benchmark::DoNotOptimize(book.get());
+    }
+    state.counters["Prefaulted"] = prefault ? 1 : 0;
+}
+
+// Registry plus one book per symbol, all drawing on the shared arena.
+static void BM_ConstructBookRegistry(benchmark::State& state) {
+    const auto symbols = static_cast<lob::SymbolId>(state.range(0));
+    const bool prefault = state.range(1) != 0;
+    for (auto _ : state) {
+        lob::BookRegistry registry;
+        if (prefault) {
+            registry.prefault();
+        }
+        for (lob::SymbolId symbol = 0; symbol < symbols; ++symbol) {
+            benchmark::DoNotOptimize(&registry.book(symbol));
+        }
+    }
+    state.counters["Symbols"] = static_cast<double>(symbols);
+    state.counters["Prefaulted"] = prefault ? 1 : 0;
+}
+
+// Constructor through every worker having built its shard; stop() is
+// untimed.
+static void BM_ConstructShardedEngine(benchmark::State& state) {
+    const std::size_t shards = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        lob::engine::ShardedEngine engine(shards, 256, false);
+        state.PauseTiming();
+        engine.stop();
+        state.ResumeTiming();
+    }
+    state.counters["Shards"] = static_cast<double>(shards);
+}
+
+BENCHMARK(BM_ConstructOrderBook)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ConstructBookRegistry)
+    ->Args({0, 0})
+    ->Args({100, 0})
+    ->Args({100, 1})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ConstructShardedEngine)->Arg(1)->Arg(4)->Unit(benchmark::kMicrosecond);
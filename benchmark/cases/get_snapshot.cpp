@@ -13,4 +13,30 @@ static void BM_GetSnapshot(benchmark::State& state) {
     runner.run([&](size_t) { return prepop.book().get_snapshot(depth); });
 }
 
+namespace {
+
+struct TopTenPolicy : lob::DefaultBookPolicy {
+    static constexpr std::size_t kTopLevels = 10;
+};
+
+}  // namespace
+
+// 10-deep poll served from the top-N cache into a caller-owned buffer.
+static void BM_GetTopSnapshot(benchmark::State& state) {
+    lob::BasicOrderBook<TopTenPolicy> book;
+    for (int i = 1; i <= PRICE_LEVELS; ++i) {
+        for (int j = 0; j < ORDERS_PER_LEVEL; ++j) {
+            (void)book.add_order(BASE_PRICE - i * TICK_SIZE, 100, lob::Side::BUY);
+            (void)book.add_order(BASE_PRICE + i * TICK_SIZE, 100, lob::Side::SELL);
+        }
+    }
+    lob::BasicOrderBook<TopTenPolicy>::TopSnapshot snapshot;
+    BenchmarkRunner runner(state, "GetTopSnapshot_depth10");
+    runner.run([&](size_t) {
+        book.get_top_snapshot(snapshot);
+        return snapshot.bid_count + snapshot.ask_count;
+    });
+}
+
 BENCHMARK(BM_GetSnapshot)->Arg(5)->Arg(10)->Arg(20)->Unit(benchmark::kNanosecond)->MinTime(3.0);
+BENCHMARK(BM_GetTopSnapshot)->Unit(benchmark::kNanosecond)->MinTime(3.0);
@@ -5,9 +5,17 @@
 #include "../utils/workload.hpp"
 #include <lob/order_book.hpp>
 
+#include <chrono>
+
 using namespace bench;
 
-static void BM_MatchOrder(benchmark::State& state) {
+// Vector returns fills in AddResult; FillSpan writes them into a caller-owned
+// fixed array; IocFillSpan does the same with an immediate-or-cancel order,
+// which never rests and never touches the order pool or index.
+enum class MatchMode { Vector, FillSpan, IocFillSpan };
+
+template <MatchMode kMode>
+static void match_order_case(benchmark::State& state, const char* csv_name) {
     warmup();
     const auto& w = workload();
     std::vector<double> latencies;
@@ -20,6 +28,8 @@ static void BM_MatchOrder(benchmark::State& state) {
         latencies.clear();
         size_t idx = 0;
         size_t total_fills = 0;
+        constexpr std::size_t kFillCapacity = 64;
+        lob::Fill fills[kFillCapacity];
         state.ResumeTiming();
 
         for (size_t i = 0; i < BENCHMARK_SAMPLES; ++i) {
@@ -40,12 +50,24 @@ static void BM_MatchOrder(benchmark::State& state) {
                 side = order.side;
             }
 
+            std::size_t fill_count = 0;
             auto start = std::chrono::high_resolution_clock::now();
-            auto result = book.add_order(price, order.quantity, side);
+            if constexpr (kMode == MatchMode::FillSpan) {
+                auto result = book.add_order(price, order.quantity, side, fills, kFillCapacity);
+                benchmark::DoNotOptimize(result);
+                fill_count = result.fill_count;
+            } else if constexpr (kMode == MatchMode::IocFillSpan) {
+                auto result = book.add_order<lob::OrderType::IOC>(price, order.quantity, side, fills, kFillCapacity);
+                benchmark::DoNotOptimize(result);
+                fill_count = result.fill_count;
+            } else {
+                auto result = book.add_order(price, order.quantity, side);
+                benchmark::DoNotOptimize(result);
+                fill_count = result.fills.size();
+            }
             auto end = std::chrono::high_resolution_clock::now();
 
-            benchmark::DoNotOptimize(result);
-            total_fills += result.fills.size();
+            total_fills += fill_count;
             latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
 
             if (book.get_total_orders() < 100) {
@@ -65,9 +87,23 @@ static void BM_MatchOrder(benchmark::State& state) {
 
     auto stats = Stats::compute(latencies);
     stats.report(state);
-    if (csv()) csv()->write("MatchOrder", stats);
+    if (csv()) csv()->write(csv_name, stats);
     state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * BENCHMARK_SAMPLES));
     state.SetLabel("Aggressive orders crossing spread");
 }
 
+static void BM_MatchOrder(benchmark::State& state) {
+    match_order_case<MatchMode::Vector>(state, "MatchOrder");
+}
+
+static void BM_MatchOrderFillSpan(benchmark::State& state) {
+    match_order_case<MatchMode::FillSpan>(state, "MatchOrderFillSpan");
+}
+
+static void BM_MatchOrderIoc(benchmark::State& state) {
+    match_order_case<MatchMode::IocFillSpan>(state, "MatchOrderIoc");
+}
+
 BENCHMARK(BM_MatchOrder)->Unit(benchmark::kNanosecond)->MinTime(3.0);
+BENCHMARK(BM_MatchOrderFillSpan)->Unit(benchmark::kNanosecond)->MinTime(3.0);
+BENCHMARK(BM_MatchOrderIoc)->Unit(benchmark::kNanosecond)->MinTime(3.0);
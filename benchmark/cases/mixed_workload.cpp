@@ -5,6 +5,8 @@
 #include "../utils/workload.hpp"
 #include <lob/order_book.hpp>
 
+#include <chrono>
+
 using namespace bench;
 
 static void BM_MixedWorkload(benchmark::State& state) {
@@ -21,4 +21,28 @@ static void BM_ModifyOrder(benchmark::State& state) {
         });
 }
 
+// Cancel/replace to another level on the same side: the order is re-queued
+// without going back through the pool or the id index.
+static void BM_ReplaceOrder(benchmark::State& state) {
+    const auto& w = workload();
+    std::unique_ptr<PrePopulatedBook> prepop;
+    const std::vector<lob::OrderId>* ids = nullptr;
+
+    BenchmarkRunner runner(state, "ReplaceOrder");
+    runner.run_with_setup(
+        [&] {
+            prepop = std::make_unique<PrePopulatedBook>(100, 10);
+            ids = &prepop->ids();
+        },
+        [&](size_t i) {
+            size_t order_idx = i % ids->size();
+            // PrePopulatedBook alternates bid/ask, so even indices are bids.
+            const lob::Price offset = static_cast<lob::Price>(1 + (i * 7) % 100) * TICK_SIZE;
+            const lob::Price price = (order_idx % 2 == 0) ? BASE_PRICE - offset : BASE_PRICE + offset;
+            return prepop->book().replace_order(
+                (*ids)[order_idx], price, w.modify_quantity(i), [](const lob::Fill&) {});
+        });
+}
+
 BENCHMARK(BM_ModifyOrder)->Unit(benchmark::kNanosecond)->MinTime(3.0);
+BENCHMARK(BM_ReplaceOrder)->Unit(benchmark::kNanosecond)->MinTime(3.0);
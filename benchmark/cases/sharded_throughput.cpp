@@ -5,6 +5,8 @@
 #include <benchmark/benchmark.h>
 #include <lob/engine/sharded_engine.hpp>
 #include <chrono>
+#include <thread>
+#include <vector>
 
 using namespace bench;
 
@@ -16,13 +18,14 @@ static void BM_ShardedThroughput(benchmark::State& state) {
     for (auto _ : state) {
         state.PauseTiming();
         lob::engine::ShardedEngine engine(shards, batch, true);
+        auto producer = engine.register_producer();
         state.ResumeTiming();
 
         std::size_t submitted = 0;
         for (std::size_t i = 0; i < BENCHMARK_SAMPLES; ++i) {
             const auto& order = w.get(i);
             const lob::engine::SymbolId symbol = static_cast<lob::engine::SymbolId>(i % (shards * 8));
-            while (!engine.submit_add(symbol, order.price, order.quantity, order.side).has_value()) {
+            while (!engine.submit_add(*producer, symbol, order.price, order.quantity, order.side).has_value()) {
                 benchmark::ClobberMemory();
             }
             ++submitted;
@@ -39,9 +42,12 @@ static void BM_ShardedThroughput(benchmark::State& state) {
     }
 }
 
+// Third argument: lob::engine::IdleStrategy (0 Yield, 1 Spin, 2 Backoff,
+// 3 Park). BusyFraction is the workers' share of cycles spent on work.
 static void BM_ShardedEndToEndLatency(benchmark::State& state) {
     const std::size_t shards = static_cast<std::size_t>(state.range(0));
     const std::size_t batch = static_cast<std::size_t>(state.range(1));
+    const auto idle = static_cast<lob::engine::IdleStrategy>(state.range(2));
     const auto& w = workload();
     constexpr std::size_t kLatencySamples = 10000;
     std::vector<double> latencies;
@@ -49,7 +55,8 @@ static void BM_ShardedEndToEndLatency(benchmark::State& state) {
 
     for (auto _ : state) {
         state.PauseTiming();
-        lob::engine::ShardedEngine engine(shards, batch, true);
+        lob::engine::ShardedEngine engine(shards, batch, true, idle);
+        auto producer = engine.register_producer();
         latencies.clear();
         state.ResumeTiming();
 
@@ -57,10 +64,11 @@ static void BM_ShardedEndToEndLatency(benchmark::State& state) {
             const auto& order = w.get(i);
             const lob::engine::SymbolId symbol = static_cast<lob::engine::SymbolId>(i % (shards * 8));
             const auto start = std::chrono::high_resolution_clock::now();
-            while (!engine.submit_add(symbol, order.price, order.quantity, order.side).has_value()) {
+            while (!engine.submit_add(*producer, symbol, order.price, order.quantity, order.side).has_value()) {
                 benchmark::ClobberMemory();
             }
-            engine.flush();
+            const std::size_t shard = engine.shard_of(symbol);
+            engine.wait(*producer, shard, engine.submitted(*producer, shard));
             const auto end = std::chrono::high_resolution_clock::now();
             latencies.push_back(std::chrono::duration<double, std::nano>(end - start).count());
         }
@@ -69,6 +77,15 @@ static void BM_ShardedEndToEndLatency(benchmark::State& state) {
         engine.stop();
         state.ResumeTiming();
 
+        double busy = 0;
+        double total = 0;
+        for (std::size_t s = 0; s < shards; ++s) {
+            const auto worker = engine.worker_stats(s);
+            busy += static_cast<double>(worker.busy_cycles);
+            total += static_cast<double>(worker.busy_cycles + worker.idle_cycles);
+        }
+        state.counters["BusyFraction"] = total > 0 ? busy / total : 0;
+
         auto stats = Stats::compute(latencies);
         stats.report(state);
         state.counters["P95_ns"] = stats.p95;
@@ -81,6 +98,95 @@ static void BM_ShardedEndToEndLatency(benchmark::State& state) {
     }
 }
 
+// Gateway shape: `producers` session threads, each with its own token,
+// submitting an equal share of the workload across every shard's symbols.
+static void BM_ShardedMultiProducerThroughput(benchmark::State& state) {
+    const std::size_t producers = static_cast<std::size_t>(state.range(0));
+    const std::size_t shards = static_cast<std::size_t>(state.range(1));
+    const auto& w = workload();
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        lob::engine::ShardedEngine engine(shards, 256, true);
+        std::vector<lob::engine::ShardedEngine::ProducerToken> tokens;
+        for (std::size_t p = 0; p < producers; ++p) {
+            tokens.push_back(*engine.register_producer());
+        }
+        state.ResumeTiming();
+
+        std::vector<std::thread> threads;
+        for (std::size_t p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                for (std::size_t i = p; i < BENCHMARK_SAMPLES; i += producers) {
+                    const auto& order = w.get(i);
+                    const lob::engine::SymbolId symbol = static_cast<lob::engine::SymbolId>(i % (shards * 8));
+                    while (!engine.submit_add(tokens[p], symbol, order.price, order.quantity, order.side)) {
+                        benchmark::ClobberMemory();
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        engine.flush();
+
+        state.PauseTiming();
+        engine.stop();
+        state.ResumeTiming();
+
+        state.counters["Producers"] = static_cast<double>(producers);
+        state.counters["Shards"] = static_cast<double>(shards);
+        state.SetItemsProcessed(state.items_processed() + static_cast<int64_t>(BENCHMARK_SAMPLES));
+    }
+}
+
+// Skewed flow: every symbol starts on shard 0, so one worker does all the
+// work. With rebalance on, a warm-up pass feeds the load counters and
+// rebalance() spreads the buckets before the timed pass.
+static void BM_ShardedSkewedThroughput(benchmark::State& state) {
+    const std::size_t shards = static_cast<std::size_t>(state.range(0));
+    const bool rebalance = state.range(1) != 0;
+    const auto& w = workload();
+    const auto symbol_of = [shards](std::size_t i) {
+        return static_cast<lob::engine::SymbolId>((i % 8) * shards);
+    };
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        lob::engine::ShardedEngine engine(shards, 256, true);
+        auto producer = *engine.register_producer();
+        std::size_t moves = 0;
+        if (rebalance) {
+            for (std::size_t i = 0; i < BENCHMARK_SAMPLES; ++i) {
+                const auto& order = w.get(i);
+                while (!engine.submit_add(producer, symbol_of(i), order.price, order.quantity, order.side)) {
+                    benchmark::ClobberMemory();
+                }
+            }
+            engine.flush();
+            moves = engine.rebalance();
+        }
+        state.ResumeTiming();
+
+        for (std::size_t i = 0; i < BENCHMARK_SAMPLES; ++i) {
+            const auto& order = w.get(i);
+            while (!engine.submit_add(producer, symbol_of(i), order.price, order.quantity, order.side)) {
+                benchmark::ClobberMemory();
+            }
+        }
+        engine.flush();
+
+        state.PauseTiming();
+        engine.stop();
+        state.ResumeTiming();
+
+        state.counters["Shards"] = static_cast<double>(shards);
+        state.counters["Moves"] = static_cast<double>(moves);
+        state.SetItemsProcessed(state.items_processed() + static_cast<int64_t>(BENCHMARK_SAMPLES));
+    }
+}
+
 BENCHMARK(BM_ShardedThroughput)
     ->Args({1, 64})
     ->Args({2, 64})
@@ -93,9 +199,32 @@ BENCHMARK(BM_ShardedThroughput)
     ->Unit(benchmark::kNanosecond)
     ->MinTime(2.0);
 
+BENCHMARK(BM_ShardedMultiProducerThroughput)
+    ->Args({1, 1})
+    ->Args({2, 1})
+    ->Args({4, 1})
+    ->Args({1, 4})
+    ->Args({2, 4})
+    ->Args({4, 4})
+    ->Args({8, 4})
+    ->Unit(benchmark::kNanosecond)
+    ->MinTime(2.0)
+    ->UseRealTime();
+
+BENCHMARK(BM_ShardedSkewedThroughput)
+    ->Args({4, 0})
+    ->Args({4, 1})
+    ->Unit(benchmark::kNanosecond)
+    ->MinTime(2.0)
+    ->UseRealTime();
+
 BENCHMARK(BM_ShardedEndToEndLatency)
-    ->Args({1, 256})
-    ->Args({2, 256})
-    ->Args({4, 256})
+    ->Args({1, 256, 0})
+    ->Args({2, 256, 0})
+    ->Args({4, 256, 0})
+    ->Args({1, 256, 1})
+    ->Args({1, 256, 2})
+    ->Args({1, 256, 3})
+    ->Args({4, 256, 3})
     ->Unit(benchmark::kNanosecond)
     ->MinTime(2.0);
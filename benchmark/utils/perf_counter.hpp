@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+// User-space data-TLB load misses of the calling thread, via
+// perf_event_open. available() is false where the kernel or the sandbox
+// gives no PMU access (perf_event_paranoid, VMs); counts stay 0 then.
+class TlbMissCounter {
+public:
+    TlbMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~TlbMissCounter() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+#endif
+    }
+
+    TlbMissCounter(const TlbMissCounter&) = delete;
+    TlbMissCounter& operator=(const TlbMissCounter&) = delete;
+
+    bool available() const { return fd_ >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#ifdef __linux__
+        if (fd_ >= 0) {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        }
+#endif
+    }
+
+    // Misses counted while started, across all start/stop spans.
+    uint64_t count() const {
+        uint64_t value = 0;
+#ifdef __linux__
+        if (fd_ >= 0 && read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) {
+            value = 0;
+        }
+#endif
+        return value;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+}  // namespace bench
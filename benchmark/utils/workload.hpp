@@ -72,7 +72,9 @@ inline const RandomWorkload& workload() {
 
 class PrePopulatedBook {
 public:
-    PrePopulatedBook(int levels = PRICE_LEVELS, int orders_per_level = ORDERS_PER_LEVEL) {
+    // handle_only: rest orders via add_order_handle (not reachable by id).
+    PrePopulatedBook(int levels = PRICE_LEVELS, int orders_per_level = ORDERS_PER_LEVEL,
+                     bool handle_only = false) {
         std::mt19937_64 rng(12345);
         std::uniform_int_distribution<uint64_t> qty_dist(100, 10000);
 
@@ -80,18 +82,32 @@ public:
             lob::Price bid_price = BASE_PRICE - i * TICK_SIZE;
             lob::Price ask_price = BASE_PRICE + i * TICK_SIZE;
             for (int j = 0; j < orders_per_level; ++j) {
-                ids_.push_back(book_.add_order(bid_price, qty_dist(rng), lob::Side::BUY).order_id);
-                ids_.push_back(book_.add_order(ask_price, qty_dist(rng), lob::Side::SELL).order_id);
+                add(bid_price, qty_dist(rng), lob::Side::BUY, handle_only);
+                add(ask_price, qty_dist(rng), lob::Side::SELL, handle_only);
             }
         }
     }
 
     lob::OrderBook& book() { return book_; }
     const std::vector<lob::OrderId>& ids() const { return ids_; }
+    const std::vector<lob::OrderHandle>& handles() const { return handles_; }
 
 private:
+    void add(lob::Price price, uint64_t quantity, lob::Side side, bool handle_only) {
+        if (handle_only) {
+            const auto result = book_.add_order_handle(price, quantity, side, nullptr, 0);
+            ids_.push_back(result.order_id);
+            handles_.push_back(result.handle);
+        } else {
+            const auto result = book_.add_order(price, quantity, side);
+            ids_.push_back(result.order_id);
+            handles_.push_back(result.handle);
+        }
+    }
+
     lob::OrderBook book_;
     std::vector<lob::OrderId> ids_;
+    std::vector<lob::OrderHandle> handles_;
 };
 
 } 
@@ -0,0 +1,109 @@
+#ifndef LOB_BOOK_POLICY_HPP
+#define LOB_BOOK_POLICY_HPP
+
+#include "page_allocator.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace lob {
+
+/**
+ * Book policies - compile-time geometry and limits for BasicOrderBook.
+ *
+ * A policy is a plain struct providing:
+ * - price_type / quantity_type: integer widths stored in Order, PriceLevel
+ *   and Fill (signed price, unsigned quantity)
+ * - kMinPrice / kMaxPrice: accepted price band; anything outside is rejected
+ * - kTickSize: price increment in raw price units. 0 leaves it to each book
+ *   (constructor argument); a fixed tick lets the compiler fold the
+ *   conversions. Ladders, bitmaps and levels are indexed in ticks.
+ * - kWindowTicks: ladder window per side in ticks, a power of two. When the
+ *   whole band fits in one window the book never re-centers and never
+ *   touches the overflow store.
+ * - kOrderCapacity / kLevelCapacity / kOverflowLevels: pre-sized storage
+ * - kAllowGrowth: whether pools, index and overflow may grow past the
+ *   pre-sized capacity (false gives allocation-free steady state)
+ * - kDepthIndex: maintain a Fenwick tree of window volume per side so
+ *   cumulative depth and sweep queries run in O(log W) instead of walking
+ *   levels, at the cost of an O(log W) update on every volume change
+ * - kTopLevels: size of the per-side top-of-book cache kept in snapshot
+ *   form, so shallow snapshots are a copy rather than a ladder walk (0 = off)
+ * - kCompactOrders: keep orders in CompactOrderStore (32-bit index links,
+ *   hot fields apart from id / original quantity / entry time) instead of
+ *   whole pooled objects; halves the memory touched per queued order
+ * - kPageOptions: backing for the book's pools and for the book object
+ *   itself (ladders inline) when heap-allocated: huge pages, mlock,
+ *   pre-faulting (see page_allocator.hpp). Default: plain operator new
+ *
+ * Policies can derive from DefaultBookPolicy and override single members.
+ */
+struct DefaultBookPolicy {
+    using price_type = Price;
+    using quantity_type = Quantity;
+
+    static constexpr price_type kMinPrice = std::numeric_limits<price_type>::min();
+    static constexpr price_type kMaxPrice = std::numeric_limits<price_type>::max();
+    static constexpr Price kTickSize = 0;
+
+    static constexpr std::size_t kWindowTicks = 1u << 12;
+    static constexpr std::size_t kOrderCapacity = 1u << 16;
+    static constexpr std::size_t kLevelCapacity = 1u << 14;
+    static constexpr std::size_t kOverflowLevels = 1u << 10;
+
+#ifdef LOB_DETERMINISTIC_POOL
+    static constexpr bool kAllowGrowth = false;
+#else
+    static constexpr bool kAllowGrowth = true;
+#endif
+
+    static constexpr bool kDepthIndex = false;
+    static constexpr std::size_t kTopLevels = 0;
+    static constexpr bool kCompactOrders = false;
+    static constexpr PageOptions kPageOptions{};
+};
+
+// One of many books sharing a BookRegistry arena: a narrow ladder, an
+// index that starts at its minimum and grows with the symbol's own order
+// count, and no per-book pools. Idle books stay a few tens of kilobytes.
+struct RegistryBookPolicy : DefaultBookPolicy {
+    static constexpr std::size_t kWindowTicks = 1u << 8;
+    static constexpr std::size_t kOrderCapacity = 0;
+    static constexpr std::size_t kLevelCapacity = 0;
+    static constexpr std::size_t kOverflowLevels = 0;
+    static constexpr bool kAllowGrowth = true;
+};
+
+namespace detail {
+
+constexpr std::size_t window_ticks_for(std::uint64_t span) noexcept {
+    std::size_t ticks = 64;
+    while (ticks < span) {
+        ticks <<= 1;
+    }
+    return ticks;
+}
+
+}  // namespace detail
+
+// Instrument with a known price band: 32-bit prices and quantities and a
+// window covering the whole band (at any tick size), so every level lives
+// in the ladder.
+template <std::int32_t MinPrice, std::int32_t MaxPrice>
+struct BandedBookPolicy : DefaultBookPolicy {
+    static_assert(MinPrice <= MaxPrice, "empty price band");
+
+    using price_type = std::int32_t;
+    using quantity_type = std::uint32_t;
+
+    static constexpr price_type kMinPrice = MinPrice;
+    static constexpr price_type kMaxPrice = MaxPrice;
+    static constexpr std::size_t kWindowTicks = detail::window_ticks_for(
+        static_cast<std::uint64_t>(static_cast<std::int64_t>(MaxPrice) - MinPrice) + 2);
+    static constexpr std::size_t kOverflowLevels = 0;
+};
+
+}  // namespace lob
+
+#endif
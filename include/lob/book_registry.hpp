@@ -0,0 +1,147 @@
+#ifndef LOB_BOOK_REGISTRY_HPP
+#define LOB_BOOK_REGISTRY_HPP
+
+#include "book_policy.hpp"
+#include "order_book.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lob {
+
+/**
+ * BookRegistry - many order books over one shared arena.
+ *
+ * Structure:
+ * - Dense SymbolId -> book table; a symbol costs one empty slot until its
+ *   first order arrives, when its book is created
+ * - One Arena (order pool + overflow level pool) shared by every book, so
+ *   storage is sized for the registry's total resting orders rather than
+ *   each symbol's peak
+ * - Books use a registry policy (RegistryBookPolicy by default): a narrow
+ *   inline ladder and an order index that grows with the symbol's activity
+ * - An idle clock: trim() releases books with no resting orders that have
+ *   not been looked up for `idle_epochs` trims, and shrinks busy-then-idle
+ *   books back to their live size
+ *
+ * A registry is single-threaded and meant to be owned by one core (one per
+ * engine shard): its arena is that core's arena. Book pointers stay valid
+ * until trim() releases the book.
+ *
+ * Performance:
+ * - book / find: O(1), one table load
+ * - trim: O(symbols)
+ */
+template <typename Policy = RegistryBookPolicy>
+class BasicBookRegistry {
+public:
+    using book_type = BasicOrderBook<Policy>;
+    using arena_type = typename book_type::Arena;
+
+    explicit BasicBookRegistry(std::size_t order_capacity = 1u << 16, std::size_t level_capacity = 1u << 10) {
+        arena_.orders.set_page_options(Policy::kPageOptions);
+        arena_.levels.set_page_options(Policy::kPageOptions);
+        arena_.orders.reserve(order_capacity);
+        arena_.levels.reserve(level_capacity);
+        arena_.orders.set_allow_growth(Policy::kAllowGrowth);
+        arena_.levels.set_allow_growth(Policy::kAllowGrowth);
+    }
+
+    BasicBookRegistry(const BasicBookRegistry&) = delete;
+    BasicBookRegistry& operator=(const BasicBookRegistry&) = delete;
+
+    // Book for `symbol`, created on first use. `tick_size` applies only to
+    // a newly created book (and only when the policy leaves kTickSize at 0).
+    book_type& book(SymbolId symbol, Price tick_size = 1) {
+        if (symbol >= entries_.size()) {
+            entries_.resize(static_cast<std::size_t>(symbol) + 1);
+        }
+        Entry& entry = entries_[symbol];
+        if (!entry.book) {
+            entry.book = std::make_unique<book_type>(arena_, tick_size);
+            ++book_count_;
+        }
+        entry.last_used = epoch_;
+        return *entry.book;
+    }
+
+    // Existing book for `symbol`, or nullptr. Does not count as activity.
+    [[nodiscard]] book_type* find(SymbolId symbol) const noexcept {
+        return symbol < entries_.size() ? entries_[symbol].book.get() : nullptr;
+    }
+
+    // Destroy `symbol`'s book, resting orders included (e.g. once they have
+    // been moved to another registry). Returns false if it has no book.
+    bool release(SymbolId symbol) noexcept {
+        if (symbol >= entries_.size() || !entries_[symbol].book) {
+            return false;
+        }
+        entries_[symbol].book.reset();
+        --book_count_;
+        return true;
+    }
+
+    // Advance the idle clock. Books not looked up through book() in the last
+    // `idle_epochs` trims are released when empty and shrunk otherwise.
+    // Returns the number of books released.
+    std::size_t trim(std::uint32_t idle_epochs = 1) {
+        std::size_t released = 0;
+        for (Entry& entry : entries_) {
+            if (!entry.book || epoch_ - entry.last_used < idle_epochs) {
+                continue;
+            }
+            if (entry.book->get_total_orders() == 0) {
+                entry.book.reset();
+                ++released;
+            } else {
+                entry.book->shrink_to_fit();
+            }
+        }
+        book_count_ -= released;
+        ++epoch_;
+        return released;
+    }
+
+    [[nodiscard]] std::size_t book_count() const noexcept { return book_count_; }
+    [[nodiscard]] std::size_t symbol_capacity() const noexcept { return entries_.size(); }
+    [[nodiscard]] arena_type& arena() noexcept { return arena_; }
+
+    // Fault in the whole arena now, e.g. on the thread that owns the
+    // registry; otherwise its pages are touched as orders first use them.
+    void prefault() noexcept {
+        arena_.orders.prefault();
+        arena_.levels.prefault();
+    }
+
+    // Bytes held by the table, every live book and the arena.
+    [[nodiscard]] std::size_t memory_usage() const noexcept {
+        std::size_t bytes = entries_.capacity() * sizeof(Entry)
+            + arena_.orders.memory_usage() + arena_.levels.memory_usage();
+        for (const Entry& entry : entries_) {
+            if (entry.book) {
+                bytes += entry.book->memory_usage();
+            }
+        }
+        return bytes;
+    }
+
+private:
+    struct Entry {
+        std::unique_ptr<book_type> book;
+        std::uint32_t last_used = 0;
+    };
+
+    // Declared before the books: they return their orders to it on destruction.
+    arena_type arena_;
+    std::vector<Entry> entries_;
+    std::size_t book_count_ = 0;
+    std::uint32_t epoch_ = 0;
+};
+
+using BookRegistry = BasicBookRegistry<>;
+
+}  // namespace lob
+
+#endif
@@ -9,4 +9,13 @@
 #define LOB_UNLIKELY(x) (x)
 #endif
 
+// Read / write prefetch into all cache levels; no-op where unsupported.
+#if defined(__GNUC__) || defined(__clang__)
+#define LOB_PREFETCH(addr)       __builtin_prefetch((addr), 0, 3)
+#define LOB_PREFETCH_WRITE(addr) __builtin_prefetch((addr), 1, 3)
+#else
+#define LOB_PREFETCH(addr)       ((void)(addr))
+#define LOB_PREFETCH_WRITE(addr) ((void)(addr))
+#endif
+
 #endif
@@ -0,0 +1,95 @@
+#ifndef LOB_DEPTH_INDEX_HPP
+#define LOB_DEPTH_INDEX_HPP
+
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lob {
+
+/**
+ * DepthIndex - Fenwick tree of resting volume and notional over ladder slots.
+ *
+ * Structure:
+ * - One node per ladder slot holding {volume, volume * ticks}
+ * - Sums are kept modulo 2^64, so notional is exact whenever the true
+ *   result fits in 64 bits, whatever the intermediate values
+ * - Volume is never negative, so prefix volumes are monotone and
+ *   lower_bound can descend the tree
+ *
+ * Slots are physical ladder indices; the book maps its circular window onto
+ * them (see BasicOrderBook depth queries).
+ *
+ * Performance:
+ * - add / prefix / lower_bound: O(log N), N = slot count (a power of two)
+ * - total: O(1)
+ */
+class DepthIndex {
+public:
+    struct Sum {
+        std::uint64_t volume;
+        std::uint64_t notional;     // sum of volume * ticks, mod 2^64
+    };
+
+    DepthIndex() = default;
+
+    // Resize to `size` slots (a power of two) and zero every sum.
+    void assign(std::size_t size) {
+        tree_.assign(size + 1, Sum{0, 0});
+        total_ = Sum{0, 0};
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return tree_.empty() ? 0 : tree_.size() - 1; }
+    [[nodiscard]] Sum total() const noexcept { return total_; }
+
+    // Add `volume_delta` resting at tick `ticks` to slot `idx`.
+    void add(std::size_t idx, std::int64_t volume_delta, Price ticks) noexcept {
+        const std::uint64_t volume = static_cast<std::uint64_t>(volume_delta);
+        const std::uint64_t notional = volume * static_cast<std::uint64_t>(ticks);
+        total_.volume += volume;
+        total_.notional += notional;
+        for (std::size_t i = idx + 1; i < tree_.size(); i += i & (~i + 1)) {
+            tree_[i].volume += volume;
+            tree_[i].notional += notional;
+        }
+    }
+
+    // Sum over slots [0, idx].
+    [[nodiscard]] Sum prefix(std::size_t idx) const noexcept {
+        Sum sum{0, 0};
+        for (std::size_t i = idx + 1; i > 0; i &= i - 1) {
+            sum.volume += tree_[i].volume;
+            sum.notional += tree_[i].notional;
+        }
+        return sum;
+    }
+
+    // Sum over slots [0, idx); idx may be 0.
+    [[nodiscard]] Sum prefix_before(std::size_t idx) const noexcept {
+        return idx == 0 ? Sum{0, 0} : prefix(idx - 1);
+    }
+
+    // Smallest slot whose prefix volume reaches `volume` (>= 1); size() if
+    // the total falls short.
+    [[nodiscard]] std::size_t lower_bound(std::uint64_t volume) const noexcept {
+        const std::size_t n = size();
+        std::size_t pos = 0;
+        for (std::size_t step = n; step > 0; step >>= 1) {
+            const std::size_t next = pos + step;
+            if (next <= n && tree_[next].volume < volume) {
+                pos = next;
+                volume -= tree_[next].volume;
+            }
+        }
+        return pos;
+    }
+
+private:
+    std::vector<Sum> tree_;     // 1-based
+    Sum total_{0, 0};
+};
+
+}  // namespace lob
+
+#endif
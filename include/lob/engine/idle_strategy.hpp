@@ -0,0 +1,99 @@
+#ifndef LOB_ENGINE_IDLE_STRATEGY_HPP
+#define LOB_ENGINE_IDLE_STRATEGY_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace lob::engine {
+
+/**
+ * What a shard worker does when none of its lanes has work.
+ *
+ * - Yield:   sched_yield per empty poll (the original behaviour)
+ * - Spin:    `pause` per empty poll; lowest wakeup latency, owns its core
+ * - Backoff: pause runs doubling up to a cap, then yield per poll
+ * - Park:    the Backoff spin, then sleep on a futex; producers pay a fence
+ *            per submit and a wake syscall only while the worker is parked
+ *
+ * Spin suits an isolated pinned core, Park a shared box. Park falls back
+ * to Backoff where futexes are unavailable.
+ */
+enum class IdleStrategy : std::uint8_t { Yield, Spin, Backoff, Park };
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield" ::: "memory");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+// Raw cycle / tick counter for the worker's busy and idle accounting.
+inline std::uint64_t read_cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+// Exponential pause run: 1, 2, 4, ... kMaxSpins pauses per call, then
+// reports that spinning is exhausted until reset().
+class IdleBackoff {
+public:
+    static constexpr std::uint32_t kMaxSpins = 64;
+
+    // false once the cap is reached; the caller escalates (yield / park).
+    bool pause() noexcept {
+        if (spins_ > kMaxSpins) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < spins_; ++i) {
+            cpu_relax();
+        }
+        spins_ <<= 1;
+        return true;
+    }
+
+    void reset() noexcept { spins_ = 1; }
+
+private:
+    std::uint32_t spins_ = 1;
+};
+
+// Sleep while `word` still holds `expected`; may return spuriously.
+inline void park_wait(std::atomic<std::uint32_t>& word, std::uint32_t expected) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    if (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+inline void park_wake(std::atomic<std::uint32_t>& word) noexcept {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+}  // namespace lob::engine
+
+#endif
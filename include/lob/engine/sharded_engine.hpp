@@ -1,15 +1,21 @@
 #ifndef LOB_ENGINE_SHARDED_ENGINE_HPP
 #define LOB_ENGINE_SHARDED_ENGINE_HPP
 
+#include "../book_registry.hpp"
+#include "../object_pool.hpp"
 #include "../order_book.hpp"
+#include "../order_index.hpp"
+#include "idle_strategy.hpp"
 #include "spsc_queue.hpp"
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <thread>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace lob::engine {
@@ -23,10 +29,98 @@ public:
         std::uint64_t client_order_id;
     };
 
+    enum class EventType : std::uint8_t {
+        Ack,            // add accepted; quantity = remaining after matching
+        Fill,           // one trade; side / client id of the aggressor
+        CancelAck,      // quantity = quantity that was resting
+        ModifyAck,      // quantity = remaining after the change (0: gone)
+        Reject,         // add rejected, or cancel/modify of an unknown order
+        LevelUpdate,    // market data: quantity now resting at side/price
+    };
+
+    // Outbound record, written by the shard worker into its event ring.
+    struct Event {
+        EventType type;
+        Side side;
+        SymbolId symbol;
+        std::uint64_t client_order_id;  // 0 for LevelUpdate
+        std::uint64_t contra_order_id;  // Fill: client id of the resting order
+        Price price;
+        Quantity quantity;
+    };
+
+    // A producer's claim on one ingress lane in every shard, obtained once
+    // from register_producer() and passed to each submit. A token is used
+    // by one thread at a time; dropping it frees the lane for the next
+    // registration. Tokens must not outlive their engine.
+    class ProducerToken {
+    public:
+        ProducerToken(ProducerToken&& other) noexcept
+            : engine_(std::exchange(other.engine_, nullptr))
+            , lane_(other.lane_) {}
+        ProducerToken& operator=(ProducerToken&& other) noexcept {
+            if (this != &other) {
+                release();
+                engine_ = std::exchange(other.engine_, nullptr);
+                lane_ = other.lane_;
+            }
+            return *this;
+        }
+        ProducerToken(const ProducerToken&) = delete;
+        ProducerToken& operator=(const ProducerToken&) = delete;
+        ~ProducerToken() { release(); }
+
+        [[nodiscard]] std::size_t lane() const noexcept { return lane_; }
+
+    private:
+        friend class ShardedEngine;
+        ProducerToken(ShardedEngine* engine, std::size_t lane) noexcept
+            : engine_(engine)
+            , lane_(lane) {}
+        void release() noexcept {
+            if (engine_) {
+                engine_->release_producer(lane_);
+                engine_ = nullptr;
+            }
+        }
+
+        ShardedEngine* engine_;
+        std::size_t lane_;
+    };
+
+    static constexpr std::size_t kMaxProducers = 32;
+    static constexpr std::size_t kMaxShards = 64;
+    // Symbols are routed in buckets of `symbol % kRouteBuckets`: a bucket is
+    // the unit of load accounting and of migration.
+    static constexpr std::size_t kRouteBuckets = 1u << 16;
+
+    // Per-shard worker counters. Cycles come from read_cycles() (TSC ticks
+    // on x86); busy covers polls that found work, idle everything else,
+    // including time spent parked.
+    struct WorkerStats {
+        std::uint64_t busy_cycles;
+        std::uint64_t idle_cycles;
+        std::uint64_t batches;
+        std::uint64_t parks;
+        std::size_t batch_limit;    // current adaptive limit
+    };
+
+    // `batch_size` caps the commands taken from one lane per poll. The
+    // actual limit adapts between kMinBatch and that cap: it doubles when a
+    // poll fills it and halves when polls come back mostly empty, so a
+    // burst after a quiet spell is published in small steps first.
+    //
+    // With `pin_workers`, shard i runs on worker_cpus[i % size]. An empty
+    // list is planned from the machine topology (plan_worker_cpus): isolated
+    // CPUs in the process's affinity mask if there are any, one per
+    // physical core before SMT siblings, never the constructing thread's
+    // core while others remain.
     explicit ShardedEngine(
         std::size_t shard_count,
         std::size_t batch_size = 256,
-        bool pin_workers = true);
+        bool pin_workers = true,
+        IdleStrategy idle = IdleStrategy::Yield,
+        std::vector<std::size_t> worker_cpus = {});
     ~ShardedEngine();
 
     ShardedEngine(const ShardedEngine&) = delete;
@@ -34,21 +128,108 @@ public:
     ShardedEngine(ShardedEngine&&) = delete;
     ShardedEngine& operator=(ShardedEngine&&) = delete;
 
+    // Claim a free lane; nullopt when kMaxProducers tokens are live.
+    // Registration, add_shard, migrate, rebalance and stop are serialized.
+    [[nodiscard]] std::optional<ProducerToken> register_producer();
+
+    // Commands from one token reach each shard in submit order. Commands
+    // from different tokens interleave in whatever order the worker fans
+    // them in, so cancel / modify an order through the token that added
+    // it (or after flush()) to be sure the add is seen first. A modify's
+    // quantity is the new total, filled part included, as in
+    // OrderBook::modify_order; at or below the filled amount the order is
+    // removed (ModifyAck with 0). Shrinking keeps queue priority.
     [[nodiscard]] std::optional<OrderHandle> submit_add(
+        ProducerToken& producer,
         SymbolId symbol,
         Price price,
         Quantity quantity,
         Side side) noexcept;
-    [[nodiscard]] bool submit_cancel(OrderHandle handle) noexcept;
-    [[nodiscard]] bool submit_modify(OrderHandle handle, Quantity new_quantity) noexcept;
+    [[nodiscard]] bool submit_cancel(ProducerToken& producer, OrderHandle handle) noexcept;
+    [[nodiscard]] bool submit_modify(ProducerToken& producer, OrderHandle handle, Quantity new_quantity) noexcept;
+
+    // Completion sequences. Each token counts the commands it has submitted
+    // to a shard; a command is complete once the worker has applied it and
+    // queued its events. The events are pollable by then unless the ring
+    // was full: the worker never waits on the consumer, so they may still
+    // sit in its backlog, ahead of any later event, until poll_events()
+    // makes room (or be dropped past it, see dropped_events()). Both counts
+    // only grow, and the worker advances the completed count once per batch.
+    [[nodiscard]] std::uint64_t submitted(const ProducerToken& producer, std::size_t shard_idx) const noexcept;
+    [[nodiscard]] std::uint64_t completed(const ProducerToken& producer, std::size_t shard_idx) const noexcept;
+    // Wait until `producer`'s first `sequence` commands to the shard are
+    // complete; pass submitted() taken right after a submit to wait for it.
+    void wait(const ProducerToken& producer, std::size_t shard_idx, std::uint64_t sequence) const noexcept;
 
+    // Shard-wide totals over every producer, for monitoring.
+    [[nodiscard]] std::uint64_t submitted(std::size_t shard_idx) const noexcept;
+    [[nodiscard]] std::uint64_t completed(std::size_t shard_idx) const noexcept;
+
+    // Wait until every command submitted to the shard (or to any shard)
+    // before the call is complete. Producers may keep submitting meanwhile.
+    void flush(std::size_t shard_idx) noexcept;
     void flush() noexcept;
+
+    // Apply everything already submitted, then join the workers. Submits
+    // after stop() fail; one racing it may be accepted and never applied.
     void stop();
 
+    // Drain up to `max` events from one shard's ring into `out`; returns the
+    // count. A command produces its fills, then its ack / reject, then level
+    // updates for every price it touched. A symbol's events follow its
+    // commands' order; a batch is applied symbol by symbol, so events of
+    // different symbols may interleave out of submit order. Each ring has
+    // a single consumer: poll a given shard from one thread at a time.
+    [[nodiscard]] std::size_t poll_events(std::size_t shard_idx, Event* out, std::size_t max) noexcept;
+    [[nodiscard]] std::size_t shard_count() const noexcept { return shard_count_.load(std::memory_order_acquire); }
+    // Current owner of `symbol`; it changes when the symbol's bucket is
+    // migrated, and the symbol's events then come from the new shard.
+    [[nodiscard]] std::size_t shard_of(SymbolId symbol) const noexcept { return route(symbol); }
+    // Events the worker discarded because the ring and its backlog were full.
+    [[nodiscard]] std::uint64_t dropped_events(std::size_t shard_idx) const noexcept;
+    [[nodiscard]] WorkerStats worker_stats(std::size_t shard_idx) const noexcept;
+    // CPU the shard's worker is pinned to; nullopt if unpinned or pinning
+    // failed.
+    [[nodiscard]] std::optional<std::size_t> worker_cpu(std::size_t shard_idx) const noexcept;
+
+    // Placement. Initially bucket b lives on shard b % shard_count.
+    //
+    // migrate() moves a symbol's bucket live: the target is told to hold
+    // back the bucket's commands, the route is switched, in-flight submits
+    // that read the old route are waited out, the old owner applies
+    // everything it already has and hands the bucket's resting orders over,
+    // and the target rebuilds the books (same queue priority, same filled
+    // amounts) before taking the held commands. No command is dropped or
+    // reordered for the moved symbols; lanes on the target that reach one of
+    // them pause until the handoff lands. Blocks until the target owns the
+    // bucket; false after stop() or for an unknown shard.
+    bool migrate(SymbolId symbol, std::size_t shard_idx);
+    // Commands applied for `symbol`'s bucket so far.
+    [[nodiscard]] std::uint64_t symbol_load(SymbolId symbol) const noexcept;
+    // Balance shards by the commands each bucket saw since the previous call
+    // (its ops rate over that interval): repeatedly move the hottest bucket
+    // that narrows the gap from the busiest to the idlest shard, until the
+    // busiest is within `tolerance` of the mean or `max_moves` are done.
+    // Returns the number of buckets moved.
+    std::size_t rebalance(std::size_t max_moves = 16, double tolerance = 0.1);
+    // Start one more shard. It owns nothing until migrate() or rebalance()
+    // moves buckets to it. nullopt at kMaxShards or after stop().
+    std::optional<std::size_t> add_shard();
+
 private:
-    static constexpr std::size_t kQueueCapacity = 1u << 16;
+    // Per producer per shard: kMaxProducers lanes of this size at most.
+    static constexpr std::size_t kLaneCapacity = 1u << 14;
+    static constexpr std::size_t kEventCapacity = 1u << 14;
+    static constexpr std::size_t kMinBatch = 8;
+    // Events the worker holds back while the ring is full; it never waits
+    // on the consumer and drops (and counts) whatever does not fit here.
+    static constexpr std::size_t kEventBacklog = 1u << 14;
+    // Client order map entries each worker reserves before it starts.
+    static constexpr std::size_t kInitialOrders = 1u << 16;
 
-    enum class CommandType : std::uint8_t { Add, Cancel, Modify, Stop };
+    static constexpr std::size_t kRouteMask = kRouteBuckets - 1;
+
+    enum class CommandType : std::uint8_t { Add, Cancel, Modify };
 
     struct Command {
         CommandType type = CommandType::Add;
@@ -59,24 +240,171 @@ private:
         Side side = Side::BUY;
     };
 
+    // A resting order as the worker knows it.
+    struct ClientOrder {
+        std::uint64_t client_order_id;
+        SymbolId symbol;
+        Side side;
+        OrderId book_order_id;
+        Price price;
+        Quantity quantity;      // total, as the book counts it for modify
+        Quantity remaining;
+    };
+
+    // Client ids are engine-wide; book order ids are per symbol. Both are
+    // issued sequentially and never 0, which suits OrderIndex.
+    using ClientIndex = OrderIndex<ClientOrder*>;
+
+    using Lane = SPSCQueue<Command, kLaneCapacity>;
+
+    // A resting order in transit between shards.
+    struct MovedOrder {
+        SymbolId symbol;
+        std::uint64_t client_order_id;
+        Side side;
+        Price price;
+        Quantity quantity;
+        Quantity remaining;
+    };
+
+    // Migration steps, in order: Expect to the target, Release to the old
+    // owner, which sends Install (with the orders) on to the target.
+    // AddLane has the worker create the lane for a newly claimed producer
+    // slot. `done` is set by the worker that finishes a step.
+    enum class ControlType : std::uint8_t { Expect, Release, Install, AddLane };
+    struct ControlMessage {
+        ControlType type;
+        std::uint32_t bucket;
+        std::size_t target;
+        std::vector<MovedOrder> orders;
+        std::atomic<bool>* done;
+        std::size_t lane = 0;
+    };
+
+    // Each shard runs one independent book per symbol routed to it. The
+    // worker builds its Shard after pinning (registry, books, arenas and the
+    // event ring included) and pre-faults the Shard itself, so first touch
+    // places the memory on its CPU's node. Arena slots are handed out
+    // lazily and their pages are faulted in by the worker as orders first
+    // use them; BookRegistry::prefault() trades start-up time for none.
+    //
+    // Ingress is one SPSC lane per registered producer. A lane is created
+    // by the worker (AddLane) the first time its slot is claimed, so it is
+    // first-touched on the worker's node like the rest of the Shard, and
+    // then kept, so a later token reuses it; the worker visits lanes
+    // [0, lane_count) round-robin.
     struct alignas(128) Shard {
-        SPSCQueue<Command, kQueueCapacity> queue;
-        OrderBook book;
-        std::unordered_map<std::uint64_t, OrderId> client_to_book_order;
-        std::thread worker;
-        std::atomic<bool> running{true};
+        std::array<std::unique_ptr<Lane>, kMaxProducers> lane_storage;
+        std::array<std::atomic<Lane*>, kMaxProducers> lanes{};
+        std::atomic<std::size_t> lane_count{0};
+        SPSCQueue<Event, kEventCapacity> events;
+        std::unique_ptr<BookRegistry> books;
+        // Resting orders: pooled records found by client id, and per symbol
+        // by book order id. Flat tables, no heap node per order.
+        ObjectPool<ClientOrder> client_pool;
+        ClientIndex client_orders;
+        std::vector<std::unique_ptr<ClientIndex>> book_orders;
+        // Worker-local: events not yet in the ring. A ring as well, so
+        // publishing part of the backlog never shifts the rest.
+        SPSCQueue<Event, kEventBacklog> outbox;
+        std::atomic<std::uint64_t> dropped_events{0};
+        // Commands applied from all lanes and WorkerStats; written only by
+        // the worker.
+        alignas(128) std::atomic<std::uint64_t> completed{0};
+        std::atomic<std::uint64_t> busy_cycles{0};
+        std::atomic<std::uint64_t> idle_cycles{0};
+        std::atomic<std::uint64_t> batches{0};
+        std::atomic<std::uint64_t> parks{0};
+        std::atomic<std::size_t> batch_limit{0};
+        // Park handshake: the worker sets parked before its last look at the
+        // lanes; a producer that then sees it bumps wake_seq and wakes it.
+        alignas(128) std::atomic<bool> parked{false};
+        std::atomic<std::uint32_t> wake_seq{0};
+        // Control messages from migrate(); rare, so a mutex is fine here.
+        // The worker looks at control_pending once per loop.
+        std::mutex control_mutex;
+        std::vector<ControlMessage> control;
+        std::atomic<bool> control_pending{false};
+        // Commands this shard applied per route bucket. Written only by
+        // this worker, so no line is shared with another shard's counts;
+        // symbol_load() and rebalance() sum over shards, which also keeps a
+        // moved bucket's earlier count.
+        std::unique_ptr<std::atomic<std::uint64_t>[]> bucket_ops;
+        std::optional<std::size_t> cpu;
+        // Set by stop(); the worker drains every lane, then exits.
+        std::atomic<bool> stop_requested{false};
     };
 
     std::size_t route(SymbolId symbol) const noexcept;
-    bool try_submit(std::size_t shard_idx, const Command& cmd) noexcept;
-    void worker_loop(std::size_t shard_idx);
+    const Lane& lane_of(const ProducerToken& producer, std::size_t shard_idx) const noexcept;
+    bool try_submit(const ProducerToken& producer, const Command& cmd) noexcept;
+    void start_shard(std::size_t shard_idx);
+    bool migrate_locked(std::uint32_t bucket, std::size_t shard_idx);
+    static void post(Shard& shard, ControlMessage message);
+    void release_producer(std::size_t lane) noexcept;
+    void worker_loop(std::size_t shard_idx, std::atomic<bool>& ready);
+    void idle_wait(Shard& shard, IdleBackoff& backoff) const noexcept;
+    static void park(Shard& shard) noexcept;
+    static void wake(Shard& shard) noexcept;
+    static bool has_work(const Shard& shard) noexcept;
 
-    std::vector<std::unique_ptr<Shard>> shards_;
-    std::unique_ptr<std::atomic<std::uint64_t>[]> producer_owner_thread_;
+    // Book commands for one symbol translated from a popped batch, with the
+    // client id each came from, applied through apply_batch on that
+    // symbol's book. A command for another symbol flushes it first.
+    struct PendingBatch {
+        SymbolId symbol = 0;
+        std::vector<BookCommand> commands;
+        std::vector<std::uint64_t> client_order_ids;
+        // Scratch: distinct prices the current command filled at.
+        std::vector<Price> fill_prices;
+    };
+    // Worker-local buffers and polling state.
+    struct WorkerState {
+        std::vector<Command> grouped;
+        std::vector<std::uint64_t> group_keys;
+        PendingBatch pending;
+        std::size_t batch_limit;
+        std::size_t first_lane = 0;
+        // Buckets announced by Expect whose orders have not arrived yet.
+        std::vector<std::uint32_t> incoming;
+    };
+    bool poll_lanes(Shard& shard, WorkerState& state);
+    void handle_control(Shard& shard, WorkerState& state);
+    static void add_lane(Shard& shard, std::size_t lane);
+    void release_bucket(Shard& shard, WorkerState& state, ControlMessage& message);
+    static void install_bucket(Shard& shard, const ControlMessage& message);
+    static ClientOrder* track_order(Shard& shard, const ClientOrder& order);
+    static void forget_order(Shard& shard, ClientOrder* order) noexcept;
+    static ClientOrder* find_by_book_id(const Shard& shard, SymbolId symbol, OrderId order_id) noexcept;
+    static void process_commands(Shard& shard, const Command* ops, std::size_t count, WorkerState& state);
+    static void apply_pending(Shard& shard, PendingBatch& pending);
+    static void emit(Shard& shard, const Event& event) noexcept;
+    static void publish_events(Shard& shard) noexcept;
+    std::uint64_t bucket_load(std::size_t bucket) const noexcept;
+
+    // Fixed-size so producers can index it while add_shard() appends.
+    std::unique_ptr<std::unique_ptr<Shard>[]> shards_;
+    std::atomic<std::size_t> shard_count_{0};
+    std::unique_ptr<std::atomic<std::uint16_t>[]> routes_;
+    // Per-bucket totals over every shard's bucket_ops as of the previous
+    // rebalance().
+    std::vector<std::uint64_t> balanced_ops_;
+    std::mutex control_mutex_;
+
+    std::array<std::atomic<bool>, kMaxProducers> producer_claimed_{};
+    // Odd while the producer is inside a submit; migrate() waits out odd
+    // values so no submit still holds a route it has replaced.
+    struct alignas(128) SubmitEpoch {
+        std::atomic<std::uint64_t> value{0};
+    };
+    std::array<SubmitEpoch, kMaxProducers> submit_epochs_{};
     std::size_t batch_size_;
     bool pin_workers_;
+    IdleStrategy idle_;
+    // CPU per shard index when pinning, kMaxShards long.
+    std::vector<std::size_t> worker_cpus_;
+    std::array<std::thread, kMaxShards> workers_;
     std::atomic<bool> stopped_{false};
-    alignas(128) std::atomic<std::uint64_t> inflight_{0};
     alignas(128) std::atomic<std::uint64_t> next_client_order_id_{1};
 };
 
@@ -1,51 +1,139 @@
 #ifndef LOB_ENGINE_SPSC_QUEUE_HPP
 #define LOB_ENGINE_SPSC_QUEUE_HPP
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cstddef>
 
 namespace lob::engine {
 
+/**
+ * SPSCQueue - bounded single-producer / single-consumer ring.
+ *
+ * Structure:
+ * - head_ / tail_ are free-running counters; slots are picked with a
+ *   power-of-two mask, and all Capacity slots are usable
+ * - Each side keeps a cached copy of the other side's counter on its own
+ *   cache line and reloads the shared one (acquire) only when the cache
+ *   says the ring looks full (producer) or empty (consumer)
+ * - Bulk transfer (try_push_n / try_pop_n) publishes a whole run with one
+ *   release store
+ * - Zero-copy consumer: peek() exposes the readable run in place, commit(n)
+ *   releases the first n slots back to the producer
+ */
 template <typename T, std::size_t Capacity>
 class SPSCQueue {
-    static_assert(Capacity > 1, "Capacity must be > 1");
+    static_assert(Capacity > 1 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two > 1");
 
 public:
+    // Contiguous readable run; may stop short at the end of the buffer.
+    struct ReadSpan {
+        const T* data;
+        std::size_t size;
+    };
+
     bool try_push(const T& value) noexcept {
         const std::size_t tail = tail_.load(std::memory_order_relaxed);
-        const std::size_t next = increment(tail);
-        if (next == head_.load(std::memory_order_acquire)) {
-            return false;
+        if (tail - cached_head_ == Capacity) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail - cached_head_ == Capacity) {
+                return false;
+            }
         }
 
-        buffer_[tail] = value;
-        tail_.store(next, std::memory_order_release);
+        buffer_[tail & kMask] = value;
+        tail_.store(tail + 1, std::memory_order_release);
         return true;
     }
 
+    // Push up to `count` items; returns how many fit.
+    std::size_t try_push_n(const T* items, std::size_t count) noexcept {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        std::size_t free = Capacity - (tail - cached_head_);
+        if (free < count) {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            free = Capacity - (tail - cached_head_);
+        }
+        const std::size_t n = std::min(count, free);
+        if (n == 0) {
+            return 0;
+        }
+
+        const std::size_t first = std::min(n, Capacity - (tail & kMask));
+        std::copy_n(items, first, buffer_.begin() + (tail & kMask));
+        std::copy_n(items + first, n - first, buffer_.begin());
+        tail_.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
     bool try_pop(T& out) noexcept {
         const std::size_t head = head_.load(std::memory_order_relaxed);
-        if (head == tail_.load(std::memory_order_acquire)) {
-            return false;
+        if (head == cached_tail_) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head == cached_tail_) {
+                return false;
+            }
         }
 
-        out = buffer_[head];
-        head_.store(increment(head), std::memory_order_release);
+        out = buffer_[head & kMask];
+        head_.store(head + 1, std::memory_order_release);
         return true;
     }
 
+    // Pop up to `count` items into `out`; returns how many were available.
+    std::size_t try_pop_n(T* out, std::size_t count) noexcept {
+        const ReadSpan first = peek(count);
+        if (first.size == 0) {
+            return 0;
+        }
+        std::copy_n(first.data, first.size, out);
+        std::size_t n = first.size;
+        if (n < count) {
+            // The run stopped at the end of the buffer; continue from slot 0.
+            const std::size_t head = head_.load(std::memory_order_relaxed) + n;
+            const std::size_t more = std::min(count - n, cached_tail_ - head);
+            std::copy_n(buffer_.begin(), more, out + n);
+            n += more;
+        }
+        commit(n);
+        return n;
+    }
+
+    // Up to `max` readable items in place, without consuming them. They stay
+    // valid until commit() releases them.
+    [[nodiscard]] ReadSpan peek(std::size_t max = Capacity) noexcept {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (cached_tail_ - head < max) {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        const std::size_t offset = head & kMask;
+        const std::size_t size = std::min({max, cached_tail_ - head, Capacity - offset});
+        return ReadSpan{buffer_.data() + offset, size};
+    }
+
+    // Consume the first `count` items of the last peek().
+    void commit(std::size_t count) noexcept {
+        head_.store(head_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    // Items ever pushed / ever committed; readable from any thread.
+    [[nodiscard]] std::size_t pushed() const noexcept { return tail_.load(std::memory_order_acquire); }
+    [[nodiscard]] std::size_t popped() const noexcept { return head_.load(std::memory_order_acquire); }
+
     [[nodiscard]] bool empty() const noexcept {
         return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
     }
 
 private:
-    static constexpr std::size_t increment(std::size_t idx) noexcept {
-        return (idx + 1) % Capacity;
-    }
+    static constexpr std::size_t kMask = Capacity - 1;
 
+    // Consumer line: its counter and its view of the producer's.
     alignas(128) std::atomic<std::size_t> head_{0};
+    std::size_t cached_tail_ = 0;
+    // Producer line.
     alignas(128) std::atomic<std::size_t> tail_{0};
+    std::size_t cached_head_ = 0;
     alignas(128) std::array<T, Capacity> buffer_{};
 };
 
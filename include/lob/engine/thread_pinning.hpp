@@ -1,16 +1,26 @@
 #ifndef LOB_ENGINE_THREAD_PINNING_HPP
 #define LOB_ENGINE_THREAD_PINNING_HPP
 
+#include <algorithm>
 #include <cstddef>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #if defined(__linux__)
 #include <pthread.h>
 #include <sched.h>
+#include <unistd.h>
 #elif defined(__APPLE__)
 #include <mach/mach.h>
 #include <mach/thread_policy.h>
 #include <pthread.h>
+#include <unistd.h>
 #endif
 
 namespace lob::engine {
@@ -40,6 +50,244 @@ inline std::size_t hardware_threads() noexcept {
     return n == 0 ? 1 : n;
 }
 
+// CPU the calling thread is running on, where the OS can tell.
+inline std::optional<std::size_t> current_cpu() noexcept {
+#if defined(__linux__)
+    const int cpu = sched_getcpu();
+    if (cpu >= 0) {
+        return static_cast<std::size_t>(cpu);
+    }
+#endif
+    return std::nullopt;
+}
+
+// Parse a kernel CPU list ("0-3,8,10-11"); empty if malformed.
+inline std::vector<std::size_t> parse_cpu_list(std::string_view text) {
+    std::vector<std::size_t> cpus;
+    const auto number = [&text](std::size_t& value) {
+        std::size_t digits = 0;
+        value = 0;
+        while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') {
+            value = value * 10 + static_cast<std::size_t>(text[digits] - '0');
+            ++digits;
+        }
+        text.remove_prefix(digits);
+        return digits != 0;
+    };
+    while (!text.empty() && (text.back() == '\n' || text.back() == ' ')) {
+        text.remove_suffix(1);
+    }
+    while (!text.empty()) {
+        std::size_t first = 0;
+        std::size_t last = 0;
+        if (!number(first)) {
+            return {};
+        }
+        last = first;
+        if (!text.empty() && text.front() == '-') {
+            text.remove_prefix(1);
+            if (!number(last) || last < first) {
+                return {};
+            }
+        }
+        for (std::size_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (!text.empty()) {
+            if (text.front() != ',') {
+                return {};
+            }
+            text.remove_prefix(1);
+        }
+    }
+    return cpus;
+}
+
+/**
+ * CpuTopology - the machine's CPUs as seen in /sys/devices/system/cpu.
+ *
+ * One entry per online logical CPU, with its physical core, package and
+ * NUMA node, whether the process may run there (sched_getaffinity) and
+ * whether the kernel isolated it (isolcpus / nohz_full setups). Where /sys
+ * is unavailable every hardware thread is its own core on node 0.
+ */
+struct CpuInfo {
+    std::size_t cpu;
+    std::size_t core;       // physical core id, unique across packages
+    std::size_t package;
+    std::size_t node;
+    bool allowed;           // in the process affinity mask
+    bool isolated;
+};
+
+struct CpuTopology {
+    std::vector<CpuInfo> cpus;  // ascending by cpu
+
+    [[nodiscard]] const CpuInfo* find(std::size_t cpu) const noexcept {
+        for (const CpuInfo& info : cpus) {
+            if (info.cpu == cpu) {
+                return &info;
+            }
+        }
+        return nullptr;
+    }
+
+    static CpuTopology detect();
+};
+
+namespace detail {
+
+inline std::string read_sys_file(const std::string& path) {
+    std::ifstream in(path);
+    std::string text;
+    std::getline(in, text);
+    return text;
+}
+
+inline std::size_t read_sys_number(const std::string& path, std::size_t fallback) {
+    const std::string text = read_sys_file(path);
+    if (text.empty() || text.front() < '0' || text.front() > '9') {
+        return fallback;
+    }
+    return static_cast<std::size_t>(std::stoull(text));
+}
+
+}  // namespace detail
+
+inline CpuTopology CpuTopology::detect() {
+    CpuTopology topology;
+    const std::string root = "/sys/devices/system/cpu/";
+    std::vector<std::size_t> online = parse_cpu_list(detail::read_sys_file(root + "online"));
+    if (online.empty()) {
+        for (std::size_t cpu = 0; cpu < hardware_threads(); ++cpu) {
+            topology.cpus.push_back(CpuInfo{cpu, cpu, 0, 0, true, false});
+        }
+        return topology;
+    }
+    const std::vector<std::size_t> isolated = parse_cpu_list(detail::read_sys_file(root + "isolated"));
+
+    // cpu -> node, from each online node's cpulist.
+    std::vector<std::size_t> node_of(online.back() + 1, 0);
+    const std::string node_root = "/sys/devices/system/node/";
+    for (const std::size_t node : parse_cpu_list(detail::read_sys_file(node_root + "online"))) {
+        const std::string list = detail::read_sys_file(node_root + "node" + std::to_string(node) + "/cpulist");
+        for (const std::size_t cpu : parse_cpu_list(list)) {
+            if (cpu < node_of.size()) {
+                node_of[cpu] = node;
+            }
+        }
+    }
+
+#if defined(__linux__)
+    cpu_set_t affinity;
+    CPU_ZERO(&affinity);
+    const bool have_affinity = sched_getaffinity(0, sizeof(affinity), &affinity) == 0;
+#endif
+    for (const std::size_t cpu : online) {
+        const std::string topo = root + "cpu" + std::to_string(cpu) + "/topology/";
+        const std::size_t package = detail::read_sys_number(topo + "physical_package_id", 0);
+        // core_id repeats across packages; the first sibling names the core.
+        const std::vector<std::size_t> siblings = parse_cpu_list(detail::read_sys_file(topo + "thread_siblings_list"));
+        const std::size_t core = siblings.empty() ? cpu : siblings.front();
+        bool allowed = true;
+#if defined(__linux__)
+        allowed = !have_affinity || (cpu < CPU_SETSIZE && CPU_ISSET(static_cast<int>(cpu), &affinity));
+#endif
+        const bool is_isolated = std::find(isolated.begin(), isolated.end(), cpu) != isolated.end();
+        topology.cpus.push_back(CpuInfo{cpu, core, package, node_of[cpu], allowed, is_isolated});
+    }
+    return topology;
+}
+
+/**
+ * CPUs for `count` pinned workers, in worker order.
+ *
+ * - Isolated CPUs the process is allowed on are used when there are any;
+ *   otherwise every allowed CPU. Isolated CPUs outside the mask (a
+ *   container or cpuset that excludes them) are never chosen: pinning
+ *   there would fail
+ * - The core of `avoid` (normally the constructing / producing thread) is
+ *   left out while other cores remain
+ * - One hardware thread per physical core first, SMT siblings only once
+ *   every core has a worker; nodes in order starting with `avoid`'s node
+ * - The list wraps when there are more workers than CPUs
+ *
+ * Empty only if the topology is.
+ */
+inline std::vector<std::size_t> plan_worker_cpus(
+    const CpuTopology& topology,
+    std::size_t count,
+    std::optional<std::size_t> avoid = std::nullopt) {
+    const bool any_isolated = std::any_of(topology.cpus.begin(), topology.cpus.end(), [](const CpuInfo& info) {
+        return info.isolated && info.allowed;
+    });
+    std::vector<CpuInfo> candidates;
+    for (const CpuInfo& info : topology.cpus) {
+        if (info.allowed && (info.isolated || !any_isolated)) {
+            candidates.push_back(info);
+        }
+    }
+
+    const CpuInfo* avoided = avoid ? topology.find(*avoid) : nullptr;
+    if (avoided) {
+        const auto other_core = std::find_if(candidates.begin(), candidates.end(), [avoided](const CpuInfo& info) {
+            return info.core != avoided->core;
+        });
+        if (other_core != candidates.end()) {
+            candidates.erase(
+                std::remove_if(
+                    candidates.begin(),
+                    candidates.end(),
+                    [avoided](const CpuInfo& info) { return info.core == avoided->core; }),
+                candidates.end());
+        }
+    }
+
+    // Rank: sibling index within the core, then node (avoid's node first),
+    // then cpu number.
+    const std::size_t home_node = avoided ? avoided->node : 0;
+    std::vector<std::pair<std::size_t, const CpuInfo*>> ranked;
+    for (const CpuInfo& info : candidates) {
+        std::size_t sibling = 0;
+        for (const CpuInfo& other : candidates) {
+            sibling += (other.core == info.core && other.cpu < info.cpu) ? 1 : 0;
+        }
+        ranked.emplace_back(sibling, &info);
+    }
+    std::sort(ranked.begin(), ranked.end(), [home_node](const auto& a, const auto& b) {
+        const auto key = [home_node](const auto& entry) {
+            return std::make_tuple(entry.first, entry.second->node != home_node, entry.second->node, entry.second->cpu);
+        };
+        return key(a) < key(b);
+    });
+
+    std::vector<std::size_t> plan;
+    for (std::size_t i = 0; i < count && !ranked.empty(); ++i) {
+        plan.push_back(ranked[i % ranked.size()].second->cpu);
+    }
+    return plan;
+}
+
+// Touch every page of [data, data + bytes) without changing its contents,
+// so later accesses take no page faults and the pages are placed by the
+// calling thread's first touch.
+inline void prefault(void* data, std::size_t bytes) noexcept {
+    if (bytes == 0) {
+        return;
+    }
+#if defined(__linux__) || defined(__APPLE__)
+    const long page_size = sysconf(_SC_PAGESIZE);
+    const std::size_t page = page_size > 0 ? static_cast<std::size_t>(page_size) : 4096;
+#else
+    const std::size_t page = 4096;
+#endif
+    auto* bytes_ptr = static_cast<volatile unsigned char*>(data);
+    for (std::size_t offset = 0; offset < bytes; offset += page) {
+        bytes_ptr[offset] = bytes_ptr[offset];
+    }
+    bytes_ptr[bytes - 1] = bytes_ptr[bytes - 1];
+}
+
 }  // namespace lob::engine
 
 #endif
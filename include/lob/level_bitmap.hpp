@@ -0,0 +1,185 @@
+#ifndef LOB_LEVEL_BITMAP_HPP
+#define LOB_LEVEL_BITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace lob {
+
+/**
+ * LevelBitmap - hierarchical occupancy bitmap over ladder indices.
+ *
+ * Structure:
+ * - Level 0 holds one bit per ladder index
+ * - Each higher level holds one bit per non-zero word of the level below,
+ *   up to a single top word (3 levels cover 262,144 indices)
+ * - Population count maintained incrementally
+ *
+ * Performance:
+ * - set/clear: O(1), touches upper levels only when a word changes emptiness
+ * - find_next/find_prev: O(levels) ctz/clz steps, independent of gap width
+ * - count: O(1)
+ */
+class LevelBitmap {
+public:
+    LevelBitmap() = default;
+
+    // Resize to `size` indices and clear every bit.
+    void assign(std::size_t size) {
+        size_ = size;
+        count_ = 0;
+        levels_.clear();
+        std::size_t bits = size;
+        do {
+            const std::size_t words = (bits + 63) / 64;
+            levels_.emplace_back(words == 0 ? 1 : words, 0);
+            bits = words;
+        } while (bits > 1);
+    }
+
+    void reset() noexcept {
+        for (auto& level : levels_) {
+            for (std::uint64_t& word : level) {
+                word = 0;
+            }
+        }
+        count_ = 0;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] std::size_t count() const noexcept { return count_; }
+    [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
+
+    [[nodiscard]] std::size_t memory_usage() const noexcept {
+        std::size_t bytes = 0;
+        for (const auto& level : levels_) {
+            bytes += level.capacity() * sizeof(std::uint64_t);
+        }
+        return bytes;
+    }
+
+    [[nodiscard]] bool test(std::size_t idx) const noexcept {
+        return (levels_[0][idx >> 6] >> (idx & 63u)) & 1u;
+    }
+
+    void set(std::size_t idx) noexcept {
+        std::uint64_t& leaf = levels_[0][idx >> 6];
+        const std::uint64_t bit = std::uint64_t{1} << (idx & 63u);
+        if (leaf & bit) {
+            return;
+        }
+        ++count_;
+        bool was_empty = (leaf == 0);
+        leaf |= bit;
+        for (std::size_t level = 1; was_empty && level < levels_.size(); ++level) {
+            idx >>= 6;
+            std::uint64_t& word = levels_[level][idx >> 6];
+            was_empty = (word == 0);
+            word |= std::uint64_t{1} << (idx & 63u);
+        }
+    }
+
+    void clear(std::size_t idx) noexcept {
+        std::uint64_t& leaf = levels_[0][idx >> 6];
+        const std::uint64_t bit = std::uint64_t{1} << (idx & 63u);
+        if (!(leaf & bit)) {
+            return;
+        }
+        --count_;
+        leaf &= ~bit;
+        bool now_empty = (leaf == 0);
+        for (std::size_t level = 1; now_empty && level < levels_.size(); ++level) {
+            idx >>= 6;
+            std::uint64_t& word = levels_[level][idx >> 6];
+            word &= ~(std::uint64_t{1} << (idx & 63u));
+            now_empty = (word == 0);
+        }
+    }
+
+    // Smallest set index >= from_idx.
+    [[nodiscard]] std::optional<std::size_t> find_next(std::size_t from_idx) const noexcept {
+        if (from_idx >= size_) {
+            return std::nullopt;
+        }
+
+        std::size_t level = 0;
+        std::size_t idx = from_idx;
+        while (true) {
+            const auto& words = levels_[level];
+            const std::size_t word = idx >> 6;
+            if (word >= words.size()) {
+                return std::nullopt;
+            }
+            const std::uint64_t bits = words[word] & (~std::uint64_t{0} << (idx & 63u));
+            if (bits != 0) {
+                return descend_lowest(level, (word << 6) + static_cast<std::size_t>(__builtin_ctzll(bits)));
+            }
+            if (level + 1 == levels_.size()) {
+                return std::nullopt;
+            }
+            idx = word + 1;
+            ++level;
+        }
+    }
+
+    // Largest set index <= from_idx.
+    [[nodiscard]] std::optional<std::size_t> find_prev(std::size_t from_idx) const noexcept {
+        if (size_ == 0) {
+            return std::nullopt;
+        }
+        if (from_idx >= size_) {
+            from_idx = size_ - 1;
+        }
+
+        std::size_t level = 0;
+        std::size_t idx = from_idx;
+        while (true) {
+            const auto& words = levels_[level];
+            const std::size_t word = idx >> 6;
+            const unsigned offset = static_cast<unsigned>(idx & 63u);
+            const std::uint64_t mask = (offset == 63) ? ~std::uint64_t{0} : ((std::uint64_t{1} << (offset + 1)) - 1);
+            const std::uint64_t bits = words[word] & mask;
+            if (bits != 0) {
+                return descend_highest(level, (word << 6) + 63u - static_cast<std::size_t>(__builtin_clzll(bits)));
+            }
+            if (word == 0 || level + 1 == levels_.size()) {
+                return std::nullopt;
+            }
+            idx = word - 1;
+            ++level;
+        }
+    }
+
+    [[nodiscard]] std::optional<std::size_t> lowest() const noexcept { return find_next(0); }
+    [[nodiscard]] std::optional<std::size_t> highest() const noexcept {
+        return size_ == 0 ? std::nullopt : find_prev(size_ - 1);
+    }
+
+private:
+    // `pos` is a set bit at `level`; follow the lowest set bits down to level 0.
+    [[nodiscard]] std::size_t descend_lowest(std::size_t level, std::size_t pos) const noexcept {
+        while (level > 0) {
+            --level;
+            pos = (pos << 6) + static_cast<std::size_t>(__builtin_ctzll(levels_[level][pos]));
+        }
+        return pos;
+    }
+
+    [[nodiscard]] std::size_t descend_highest(std::size_t level, std::size_t pos) const noexcept {
+        while (level > 0) {
+            --level;
+            pos = (pos << 6) + 63u - static_cast<std::size_t>(__builtin_clzll(levels_[level][pos]));
+        }
+        return pos;
+    }
+
+    std::vector<std::vector<std::uint64_t>> levels_;
+    std::size_t size_ = 0;
+    std::size_t count_ = 0;
+};
+
+}  // namespace lob
+
+#endif
@@ -2,7 +2,10 @@
 #define LOB_OBJECT_POOL_HPP
 
 #include "compiler.hpp"
+#include "page_allocator.hpp"
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <type_traits>
 #include <utility>
@@ -10,8 +13,29 @@
 
 namespace lob {
 
+/**
+ * ObjectPool - block-allocated pool with lazy slot initialisation.
+ *
+ * Every node carries a stable slot index and a generation counter. The
+ * generation is bumped on both create and destroy, so it is odd while the
+ * slot is live; resolve(slot, generation) therefore rejects handles to
+ * objects that have since been destroyed or recycled.
+ *
+ * Slots come from two places: recycled ones from an intrusive free list,
+ * never-used ones from a bump pointer (the high-water mark) into the
+ * reserved blocks. A node is first written when it is first handed out, so
+ * reserve() is O(1) in the slot count and memory is touched on demand, or
+ * all at once by prefault(). Slots at or above the high-water mark were
+ * never initialised and never resolve.
+ *
+ * Blocks are carved from PageRegions (page_allocator.hpp): reserve() takes
+ * one region for all the blocks it adds, so with huge pages requested the
+ * whole reservation can sit on a few 2 MB pages.
+ */
 template <typename T, std::size_t BlockSize = 4096>
 class ObjectPool {
+    static_assert((BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two");
+
 public:
     ObjectPool() = default;
     ~ObjectPool() = default;
@@ -23,8 +47,21 @@ public:
 
     void reserve(std::size_t object_count) {
         const std::size_t needed_blocks = (object_count + BlockSize - 1) / BlockSize;
-        while (blocks_.size() < needed_blocks) {
-            allocate_block();
+        if (blocks_.size() < needed_blocks) {
+            allocate_blocks(needed_blocks - blocks_.size());
+        }
+    }
+
+    // Backing for blocks allocated from now on; set before reserve().
+    void set_page_options(PageOptions options) noexcept {
+        page_options_ = options;
+    }
+
+    // Fault in every reserved page now (e.g. on the thread that will use
+    // the pool) instead of on first use. Contents are unchanged.
+    void prefault() noexcept {
+        for (PageRegion& region : regions_) {
+            region.prefault();
         }
     }
 
@@ -40,18 +77,59 @@ public:
         return blocks_.size();
     }
 
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return blocks_.size() * BlockSize;
+    }
+
+    // Slots ever handed out; nodes below this have been initialised.
+    [[nodiscard]] std::size_t high_water() const noexcept {
+        return high_water_;
+    }
+
+    // Bytes held in blocks, live or free.
+    [[nodiscard]] std::size_t memory_usage() const noexcept {
+        return capacity() * sizeof(Node);
+    }
+
+    [[nodiscard]] static std::uint32_t slot_of(const T* object) noexcept {
+        return node_of(object)->slot;
+    }
+
+    [[nodiscard]] static std::uint32_t generation_of(const T* object) noexcept {
+        return node_of(object)->generation;
+    }
+
+    // O(1) handle resolution: bounds check plus generation check.
+    [[nodiscard]] T* resolve(std::uint32_t slot, std::uint32_t generation) const noexcept {
+        if (LOB_UNLIKELY(slot >= high_water_)) {
+            return nullptr;
+        }
+        Node* node = node_at(slot);
+        if (LOB_UNLIKELY(node->generation != generation || (generation & 1u) == 0)) {
+            return nullptr;
+        }
+        return reinterpret_cast<T*>(&node->storage);
+    }
+
     template <typename... Args>
     T* create(Args&&... args) {
-        if (LOB_UNLIKELY(!free_list_)) {
-            if (LOB_UNLIKELY(!allow_growth_)) {
-                ++growth_failures_;
-                return nullptr;
+        Node* node = free_list_;
+        if (LOB_LIKELY(node)) {
+            free_list_ = node->next;
+        } else {
+            if (LOB_UNLIKELY(high_water_ == capacity())) {
+                if (LOB_UNLIKELY(!allow_growth_)) {
+                    ++growth_failures_;
+                    return nullptr;
+                }
+                allocate_blocks(1);
             }
-            allocate_block();
+            node = node_at(high_water_);
+            node->slot = static_cast<std::uint32_t>(high_water_);
+            node->generation = 0;
+            ++high_water_;
         }
-
-        Node* node = free_list_;
-        free_list_ = free_list_->next;
+        ++node->generation;
 
         T* object = reinterpret_cast<T*>(&node->storage);
         ::new (static_cast<void*>(object)) T(std::forward<Args>(args)...);
@@ -64,30 +142,51 @@ public:
         }
 
         object->~T();
-        Node* node = reinterpret_cast<Node*>(object);
+        Node* node = node_of(object);
+        ++node->generation;
         node->next = free_list_;
         free_list_ = node;
     }
 
 private:
-    union Node {
-        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
-        Node* next;
+    struct Node {
+        union {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+            Node* next;
+        };
+        std::uint32_t slot;
+        std::uint32_t generation;
     };
 
-    void allocate_block() {
-        blocks_.emplace_back(new Node[BlockSize]);
-        Node* block = blocks_.back().get();
+    static Node* node_of(const T* object) noexcept {
+        return reinterpret_cast<Node*>(const_cast<T*>(object));
+    }
+
+    [[nodiscard]] Node* node_at(std::size_t slot) const noexcept {
+        return blocks_[slot / BlockSize] + (slot % BlockSize);
+    }
 
-        for (std::size_t i = 0; i + 1 < BlockSize; ++i) {
-            block[i].next = &block[i + 1];
+    // Add at least `count` blocks in one region; with huge pages the count
+    // is rounded up to fill the region's last huge page.
+    void allocate_blocks(std::size_t count) {
+        constexpr std::size_t kBlockBytes = sizeof(Node) * BlockSize;
+        if (page_options_.huge) {
+            const std::size_t huge_bytes = (count * kBlockBytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+            count = std::max(count, huge_bytes / kBlockBytes);
+        }
+        PageRegion& region = regions_.emplace_back(count * kBlockBytes, page_options_);
+        Node* nodes = static_cast<Node*>(region.data());
+        std::uninitialized_default_construct_n(nodes, count * BlockSize);
+        for (std::size_t b = 0; b < count; ++b) {
+            blocks_.push_back(nodes + b * BlockSize);
         }
-        block[BlockSize - 1].next = free_list_;
-        free_list_ = block;
     }
 
-    std::vector<std::unique_ptr<Node[]>> blocks_;
-    Node* free_list_ = nullptr;
+    std::vector<Node*> blocks_;
+    std::vector<PageRegion> regions_;
+    Node* free_list_ = nullptr;        // recycled slots only
+    std::size_t high_water_ = 0;
+    PageOptions page_options_{};
     bool allow_growth_ = true;
     std::size_t growth_failures_ = 0;
 };
@@ -8,18 +8,22 @@
 
 namespace lob {
 
-class PriceLevel;
+// Price/Quantity widths come from the book policy; narrower types shrink
+// every resting order.
+template <typename PriceT, typename QuantityT>
+struct BasicOrder {
+    using price_type = PriceT;
+    using quantity_type = QuantityT;
 
-struct Order {
     OrderId id;
-    Price price;
-    Quantity quantity;
-    Quantity remaining_quantity;
-    Order* prev_order;
-    Order* next_order;
-    PriceLevel* parent_level;
-    Timestamp entry_time;
+    PriceT price;
+    QuantityT quantity;
+    QuantityT remaining_quantity;
     Side side;
+    bool indexed;   // Reachable by OrderId (false for handle-only orders)
+    BasicOrder* prev_order;
+    BasicOrder* next_order;
+    Timestamp entry_time;
 
     static Timestamp now_timestamp() noexcept {
 #ifdef LOB_ENABLE_ENTRY_TIME
@@ -31,28 +35,30 @@ struct Order {
 #endif
     }
     
-    Order(OrderId id_, Price price_, Quantity quantity_, Side side_) noexcept
+    BasicOrder(OrderId id_, PriceT price_, QuantityT quantity_, Side side_, bool indexed_ = true) noexcept
         : id(id_)
         , price(price_)
         , quantity(quantity_)
         , remaining_quantity(quantity_)
+        , side(side_)
+        , indexed(indexed_)
         , prev_order(nullptr)
         , next_order(nullptr)
-        , parent_level(nullptr)
         , entry_time(now_timestamp())
-        , side(side_)
     {}
 
     [[nodiscard]] bool is_filled() const noexcept { 
         return remaining_quantity == 0; 
     }
 
-    void fill(Quantity qty) noexcept {
+    void fill(QuantityT qty) noexcept {
         remaining_quantity = (qty >= remaining_quantity) ? 0 : remaining_quantity - qty;
     }
 };
 
-static_assert(sizeof(Order) <= 72, "Order struct exceeds 72 bytes — review field layout");
+using Order = BasicOrder<Price, Quantity>;
+
+static_assert(sizeof(Order) <= 64, "Order struct exceeds 64 bytes — review field layout");
 
 }
 
@@ -3,119 +3,504 @@
 
 #include "price_level.hpp"
 #include "object_pool.hpp"
+#include "order_store.hpp"
+#include "order_index.hpp"
+#include "level_bitmap.hpp"
+#include "book_policy.hpp"
+#include "tick_scale.hpp"
+#include "depth_index.hpp"
+#include "compiler.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <unordered_map>
+#include <limits>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <optional>
 
 namespace lob {
 
 /**
- * OrderBook - cache-friendly ladder-based order book.
- * 
+ * BasicOrderBook - cache-friendly ladder-based order book.
+ *
  * Structure:
- * - Tick-indexed ladders for buy and sell levels
- * - Hash map for O(1) order lookup by order ID
+ * - Prices are converted to tick numbers on entry (off-tick prices are
+ *   rejected) and back to raw prices in fills and queries
+ * - Circular tick-indexed window per side: a tick t maps to slot
+ *   (t & (W - 1)), and the W slots cover [window_lo_, window_lo_ + W).
+ *   Level headers live inline in the slots; a bitmap marks occupied ones.
+ *   The window re-centers on the touch when the market drifts; levels that
+ *   fall out of it move to the overflow store instead of forcing a rebuild.
+ * - Sorted overflow store per side for levels outside the window, so far
+ *   from-market orders are kept rather than rejected (pool-allocated)
+ * - Flat open-addressing index for O(1) order lookup by order ID
+ * - Orders in a pooled store (whole objects, pointer links) or a compact
+ *   one (32-bit links, hot/cold split), per Policy::kCompactOrders
  * - Cached pointers to best bid (highest_buy_) and best ask (lowest_sell_)
- * 
+ * - Optional Fenwick tree of window volume per side (Policy::kDepthIndex)
+ *
+ * Geometry, capacities, integer widths and growth come from Policy at
+ * compile time (see book_policy.hpp): the ladders are std::arrays, band
+ * checks fold away for unbounded policies, and a policy whose band fits in
+ * one window compiles out re-centering and the overflow store entirely.
+ *
  * Performance:
  * - Add order (existing level): O(1)
- * - Add order (new level): O(1) amortized
- * - Cancel order: O(1)
+ * - Add order (new level in window): O(1) amortized
+ * - Add order (new level outside window): O(log F + F) for F overflow levels
+ * - Re-center: O(levels moved), amortized over the drift that triggered it
+ * - Cancel order: O(1) in window, O(log F) in overflow
  * - Execute order: O(1)
  * - GetBestBid/Ask: O(1)
  * - GetVolumeAtLimit: O(1)
+ * - Depth / sweep queries: O(log W + overflow levels crossed) with
+ *   kDepthIndex, O(levels crossed) without
  */
-class OrderBook {
+template <typename Policy>
+class BasicOrderBook {
 public:
+    using policy_type = Policy;
+    using price_type = typename Policy::price_type;
+    using quantity_type = typename Policy::quantity_type;
+    using order_store_type = std::conditional_t<Policy::kCompactOrders,
+        CompactOrderStore<price_type, quantity_type>,
+        PooledOrderStore<price_type, quantity_type>>;
+    using order_type = typename order_store_type::order_type;
+    using level_type = BasicPriceLevel<price_type, quantity_type, order_type>;
+    using fill_type = BasicFill<price_type, quantity_type>;
+    using command_type = BasicBookCommand<price_type, quantity_type>;
+
+    static_assert(std::is_integral_v<price_type> && std::is_signed_v<price_type>,
+                  "price_type must be a signed integer");
+    static_assert(std::is_integral_v<quantity_type> && std::is_unsigned_v<quantity_type>,
+                  "quantity_type must be an unsigned integer");
+    static_assert(Policy::kWindowTicks >= 64 && (Policy::kWindowTicks & (Policy::kWindowTicks - 1)) == 0,
+                  "kWindowTicks must be a power of two >= 64");
+    static_assert(Policy::kMinPrice <= Policy::kMaxPrice, "empty price band");
+
+    static constexpr std::size_t kWindowTicks = Policy::kWindowTicks;
+
+    static_assert(Policy::kTickSize >= 0, "kTickSize must be positive, or 0 for a per-book tick");
+    static constexpr bool kRuntimeTick = Policy::kTickSize == 0;
+
+    // Band narrower than the full price_type range: out-of-band prices are rejected.
+    static constexpr bool kBounded =
+        Policy::kMinPrice != std::numeric_limits<price_type>::min() ||
+        Policy::kMaxPrice != std::numeric_limits<price_type>::max();
+
+    // Whole band fits in one window: no re-centering, no overflow store.
+    // A per-book tick is at least 1, so the band span bounds its tick span.
+    static constexpr bool kSingleWindow =
+        (static_cast<std::uint64_t>(static_cast<std::int64_t>(Policy::kMaxPrice)) -
+         static_cast<std::uint64_t>(static_cast<std::int64_t>(Policy::kMinPrice))) /
+        static_cast<std::uint64_t>(kRuntimeTick ? 1 : Policy::kTickSize) < kWindowTicks - 1;
+
     struct AddResult {
         OrderId order_id;
-        std::vector<Fill> fills;
-        Quantity remaining_quantity;
+        std::vector<fill_type> fills;
+        quantity_type remaining_quantity;
+        OrderHandle handle;     // {0, 0} unless the order rested
+    };
+
+    // Result of the allocation-free add_order overloads. Fills are handed to
+    // the caller's sink as they happen, so only the totals are returned here.
+    struct AddSummary {
+        OrderId order_id;
+        quantity_type remaining_quantity;
+        std::size_t fill_count;
+        // Span overload only: the fill buffer filled up while the order still
+        // crossed the book. The unmatched residual is cancelled, not rested.
+        bool truncated;
+        OrderHandle handle;     // {0, 0} unless the order rested
+    };
+
+    struct BookSnapshot {
+        struct Level {
+            price_type price;
+            quantity_type quantity;
+            size_t order_count;
+        };
+        std::vector<Level> bids;
+        std::vector<Level> asks;
+    };
+
+    static constexpr std::size_t kTopLevels = Policy::kTopLevels;
+
+    // Storage shared by many books (see BookRegistry): resting orders and
+    // overflow levels come from here instead of per-book pools. Handles
+    // stay per-book: use one only on the book that issued it.
+    struct Arena {
+        ObjectPool<order_type> orders;
+        ObjectPool<level_type> levels;
+    };
+
+    // Fixed-size copy of the cached top levels (Policy::kTopLevels).
+    struct TopSnapshot {
+        std::array<typename BookSnapshot::Level, kTopLevels> bids;
+        std::array<typename BookSnapshot::Level, kTopLevels> asks;
+        std::size_t bid_count;
+        std::size_t ask_count;
+    };
+
+    // Outcome of sweeping `quantity` through one side from the best level,
+    // as a marketable order would, without touching the book.
+    struct SweepQuote {
+        std::uint64_t quantity;     // fillable quantity, <= requested
+        price_type last_price;      // worst price reached; 0 if nothing fills
+        Price notional;             // sum of price * quantity over the fills
+
+        [[nodiscard]] double vwap() const noexcept {
+            return quantity == 0 ? 0.0 : static_cast<double>(notional) / static_cast<double>(quantity);
+        }
     };
 
 private:
+    using Ladder = std::array<level_type, kWindowTicks>;
+    static constexpr std::size_t kWindowMask = kWindowTicks - 1;
+
+    // Per-book tick; unused when the policy fixes kTickSize.
+    TickScale tick_scale_;
+    static constexpr TickScale kFixedScale{kRuntimeTick ? 1 : Policy::kTickSize};
+
     // Order storage - keyed by order ID for O(1) lookup.
-    std::unordered_map<OrderId, Order*> orders_;
-
-    // Tick-indexed ladders (cache-friendly contiguous structures).
-    std::vector<PriceLevel*> bid_ladder_;
-    std::vector<PriceLevel*> ask_ladder_;
-    std::vector<std::uint64_t> bid_active_words_;
-    std::vector<std::uint64_t> ask_active_words_;
-    Price min_price_;
-    Price max_price_;
-    bool ladder_initialized_;
-    
-    // Cached best prices for O(1) access
-    PriceLevel* highest_buy_;   // Best bid (max price in buy tree)
-    PriceLevel* lowest_sell_;   // Best ask (min price in sell tree)
-
-    ObjectPool<Order> order_pool_;
-    ObjectPool<PriceLevel> level_pool_;
-
-    std::vector<Fill> fill_buffer_;
+    OrderIndex<order_type*> orders_;
+
+    // Circular tick-indexed window (cache-friendly contiguous structures).
+    // Slot i holds the level whose tick t satisfies (t & kWindowMask) == i
+    // and window_lo_ <= t < window_lo_ + kWindowTicks, valid while its
+    // active bit is set.
+    Ladder bid_ladder_;
+    Ladder ask_ladder_;
+    LevelBitmap bid_active_;
+    LevelBitmap ask_active_;
+    Price window_lo_;
+
+    // Levels outside the window, sorted worst to best so each side's best
+    // overflow level sits at back().
+    std::vector<level_type*> bid_overflow_;
+    std::vector<level_type*> ask_overflow_;
+
+    // Cached best prices for O(1) access (re-resolved after re-centering,
+    // which moves level headers between ladder and overflow)
+    level_type* highest_buy_;   // Best bid (max price in buy tree)
+    level_type* lowest_sell_;   // Best ask (min price in sell tree)
+
+    // Window volume by ladder slot; empty unless Policy::kDepthIndex.
+    DepthIndex bid_depth_;
+    DepthIndex ask_depth_;
+
+    // Best kTopLevels levels per side, best first, in snapshot form plus
+    // their ticks. Holds every level while a side has fewer than that.
+    struct TopCache {
+        std::array<typename BookSnapshot::Level, kTopLevels> levels;
+        std::array<Price, kTopLevels> ticks;
+        std::size_t count;
+    };
+    TopCache bid_top_;
+    TopCache ask_top_;
+
+    order_store_type order_store_;
+    ObjectPool<level_type> own_level_pool_;
+    ObjectPool<level_type>* level_pool_;    // overflow levels only; own or arena
 
     OrderId next_order_id_;
+    std::size_t unindexed_orders_;
+
+    // Bounded sink backing the span overload of add_order.
+    struct SpanFillSink {
+        fill_type* out;
+        std::size_t capacity;
+        std::size_t size;
+
+        [[nodiscard]] bool full() const noexcept { return size == capacity; }
+        [[nodiscard]] std::size_t remaining() const noexcept { return capacity - size; }
+        void operator()(const fill_type& fill) noexcept { out[size++] = fill; }
+    };
+
+    template <typename Sink, typename = void>
+    struct is_bounded_sink : std::false_type {};
+    template <typename Sink>
+    struct is_bounded_sink<Sink, std::void_t<decltype(std::declval<const Sink&>().full())>>
+        : std::true_type {};
+
+    // Bounded sinks that report their free space let FOK orders check up
+    // front that every fill will fit.
+    template <typename Sink>
+    [[nodiscard]] static std::size_t sink_room(const Sink& sink) noexcept {
+        if constexpr (std::is_same_v<Sink, SpanFillSink>) {
+            return sink.remaining();
+        } else {
+            return ~std::size_t{0};
+        }
+    }
+
+    [[nodiscard]] const TickScale& scale() const noexcept {
+        if constexpr (kRuntimeTick) {
+            return tick_scale_;
+        } else {
+            return kFixedScale;
+        }
+    }
+    [[nodiscard]] price_type to_price(Price ticks) const noexcept {
+        return static_cast<price_type>(scale().to_price(ticks));
+    }
+
+    [[nodiscard]] Price window_hi() const noexcept {
+        return window_lo_ + static_cast<Price>(kWindowTicks - 1);
+    }
+    [[nodiscard]] bool in_window(Price price) const noexcept {
+        if constexpr (kSingleWindow) {
+            return true;
+        } else {
+            return static_cast<std::uint64_t>(price) - static_cast<std::uint64_t>(window_lo_) < kWindowTicks;
+        }
+    }
+    [[nodiscard]] static std::size_t ladder_index(Price ticks) noexcept {
+        return static_cast<std::size_t>(static_cast<std::uint64_t>(ticks)) & kWindowMask;
+    }
 
-    void refresh_best_levels() noexcept;
-    void initialize_ladders(Price min_price, Price max_price);
-    void ensure_price_range(Price price);
-    [[nodiscard]] std::size_t ladder_index(Price price) const noexcept;
-    void set_active(std::vector<std::uint64_t>& words, std::size_t idx) noexcept;
-    void clear_active(std::vector<std::uint64_t>& words, std::size_t idx) noexcept;
-    [[nodiscard]] std::size_t word_count() const noexcept;
-    [[nodiscard]] std::optional<std::size_t> find_prev_active(
-        const std::vector<std::uint64_t>& words,
-        std::size_t from_idx) const noexcept;
-    [[nodiscard]] std::optional<std::size_t> find_next_active(
-        const std::vector<std::uint64_t>& words,
-        std::size_t from_idx) const noexcept;
-
-    // Order book operations — templatized on Side to eliminate branches in inner loops
-    template<Side S> void match_order_impl(Order* incoming);
-    template<Side S> void add_order_to_book_impl(Order* order);
-    template<Side S> void remove_order_from_book_impl(Order* order);
+    // Level management across window and overflow.
+    template<Side S> level_type* find_or_create_level(Price price);
+    template<Side S> void erase_level(level_type* level) noexcept;
+    template<Side S> [[nodiscard]] level_type* next_level(Price price) const noexcept;
+    template<Side S> [[nodiscard]] level_type* window_next_level(Price price) const noexcept;
+    template<Side S> level_type* create_overflow_level(Price price);
+    // Level in ladder slot `idx`; mutable from const lookups as with any
+    // level the book hands out.
+    template<Side S> [[nodiscard]] level_type* ladder_level(std::size_t idx) const noexcept;
+    // Existing level at tick `price`, in window or overflow.
+    template<Side S> [[nodiscard]] level_type* level_at(Price price) const noexcept;
+    void maybe_recenter(Price price);
+    template<Side S> void evict_outside_window();
+    template<Side S> void migrate_into_window();
+
+    // Order book operations — templatized on Side to eliminate branches in inner loops.
+    // match_order_impl returns true when a bounded sink filled up while the
+    // incoming order still crossed the book.
+    template<Side S, typename Sink>
+    bool match_order_impl(order_type* incoming, OrderId incoming_id, Sink& sink, std::size_t& fill_count);
+    template<bool Indexed, OrderType Type, typename Sink>
+    AddSummary add_order_impl(price_type price, quantity_type quantity, Side side, Sink& sink);
+    template<Side S> [[nodiscard]] bool can_fill(Price ticks, quantity_type quantity, std::size_t max_fills) const noexcept;
+    [[nodiscard]] order_type* resolve(OrderHandle handle) const noexcept;
+    [[nodiscard]] OrderHandle handle_of(const order_type* order) const noexcept {
+        return order_store_.handle_of(order);
+    }
+    // Level an order rests on, found from its price.
+    template<Side S> [[nodiscard]] level_type* level_of(const order_type* order) const noexcept;
+    void unindex(const order_type* order) noexcept;
+    void cancel_resting(order_type* order) noexcept;
+    void modify_resting(order_type* order, quantity_type new_quantity) noexcept;
+    template<typename Sink>
+    AddSummary replace_resting(order_type* order, price_type new_price, quantity_type new_quantity, Sink& sink);
+    // Batch pipeline: commands this far ahead get their index slot
+    // prefetched, half as far their order, a quarter as far their level.
+    // The order stage is the only index lookup before execution; what it
+    // finds is passed on to the later stages (and possibly stale by then).
+    static constexpr std::size_t kPrefetchDistance = 8;
+    void prefetch_index(const command_type& cmd) const noexcept;
+    [[nodiscard]] order_type* prefetch_order(const command_type& cmd) const noexcept;
+    void prefetch_neighbours(const command_type& cmd, const order_type* order) const noexcept;
+    // `order` if it is still live under `order_id`, else the index lookup.
+    [[nodiscard]] order_type* recheck(order_type* order, OrderId order_id) const noexcept;
+    template<typename Sink>
+    AddSummary dispatch_add(const command_type& cmd, Sink& sink);
+    // Depth index maintenance and queries (ticks throughout).
+    template<Side S> void track_depth(const level_type* level, std::int64_t volume_delta) noexcept;
+    // Called after a level's volume or order count changed: keeps the depth
+    // index and the top-N cache current.
+    template<Side S> void level_changed(const level_type* level, std::int64_t volume_delta) noexcept;
+    template<Side S> void refresh_top(const level_type* level) noexcept;
+    template<Side S> void erase_top(Price price) noexcept;
+    [[nodiscard]] DepthIndex::Sum window_sum(const DepthIndex& depth, Price first, Price last) const noexcept;
+    [[nodiscard]] DepthIndex::Sum logical_prefix(const DepthIndex& depth, std::size_t slot) const noexcept;
+    [[nodiscard]] std::size_t logical_search(const DepthIndex& depth, std::uint64_t volume) const noexcept;
+    template<Side S> [[nodiscard]] std::uint64_t depth_to(Price ticks) const noexcept;
+    template<Side S> [[nodiscard]] quantity_type quantity_at(price_type price) const noexcept;
+    template<Side S> [[nodiscard]] SweepQuote sweep(std::uint64_t quantity) const noexcept;
+    template<Side S> [[nodiscard]] bool add_order_to_book_impl(order_type* order);
+    template<Side S> void remove_order_from_book_impl(order_type* order);
     void clear();
 
+    BasicOrderBook(Price tick_size, Arena* arena);
+
 public:
-    OrderBook();
-    ~OrderBook();
-    
-    OrderBook(const OrderBook&) = delete;
-    OrderBook& operator=(const OrderBook&) = delete;
-    OrderBook(OrderBook&&) = delete;
-    OrderBook& operator=(OrderBook&&) = delete;
-
-    [[nodiscard]] AddResult add_order(Price price, Quantity quantity, Side side);
+    // `tick_size` is in raw price units and only used when the policy leaves
+    // kTickSize at 0. Values <= 0 are treated as 1.
+    explicit BasicOrderBook(Price tick_size = 1) : BasicOrderBook(tick_size, nullptr) {}
+    // Book drawing orders and overflow levels from a shared arena, which
+    // must outlive it. Pooled orders only.
+    explicit BasicOrderBook(Arena& arena, Price tick_size = 1) : BasicOrderBook(tick_size, &arena) {
+        static_assert(!Policy::kCompactOrders, "shared arenas hold pooled orders");
+    }
+    ~BasicOrderBook();
+
+    BasicOrderBook(const BasicOrderBook&) = delete;
+    BasicOrderBook& operator=(const BasicOrderBook&) = delete;
+    BasicOrderBook(BasicOrderBook&&) = delete;
+    BasicOrderBook& operator=(BasicOrderBook&&) = delete;
+
+    // A heap-allocated book (e.g. from BookRegistry) gets its own region
+    // under non-default Policy::kPageOptions, so the inline ladders share
+    // its huge pages / lock / pre-faulting.
+    static void* operator new(std::size_t bytes) {
+        if constexpr (Policy::kPageOptions.plain()) {
+            return ::operator new(bytes);
+        } else {
+            return page_new(bytes, Policy::kPageOptions);
+        }
+    }
+    static void operator delete(void* book) noexcept {
+        if constexpr (Policy::kPageOptions.plain()) {
+            ::operator delete(book);
+        } else {
+            page_delete(book);
+        }
+    }
+
+    [[nodiscard]] Price tick_size() const noexcept { return scale().tick_size(); }
+
+    // Prices below are raw prices; orders at off-tick prices are rejected
+    // with order_id 0.
+    [[nodiscard]] AddResult add_order(price_type price, quantity_type quantity, Side side);
+
+    // Order types other than LIMIT are chosen with a template argument, e.g.
+    // add_order<OrderType::IOC>(...). MARKET ignores `price`. MARKET, IOC and
+    // FOK never rest: they match against a stack-local order and touch
+    // neither the order pool nor the index. Rejected, killed (FOK) and
+    // would-cross (POST_ONLY) orders return order_id 0.
+    template <OrderType Type>
+    [[nodiscard]] AddResult add_order(price_type price, quantity_type quantity, Side side);
+
+    // Zero-allocation add: each fill is passed to `sink(const fill_type&)` as
+    // it is generated, in match order. The sink must not throw.
+    template <OrderType Type = OrderType::LIMIT, typename FillSink>
+    [[nodiscard]] AddSummary add_order(price_type price, quantity_type quantity, Side side, FillSink&& sink);
+
+    // Fixed-capacity add: fills are written to `fills[0..capacity)`. Matching
+    // stops once the buffer is full (see AddSummary::truncated); FOK orders
+    // that would need more fills than fit are killed instead.
+    [[nodiscard]] AddSummary add_order(
+        price_type price, quantity_type quantity, Side side, fill_type* fills, std::size_t capacity) noexcept;
+    template <OrderType Type>
+    [[nodiscard]] AddSummary add_order(
+        price_type price, quantity_type quantity, Side side, fill_type* fills, std::size_t capacity) noexcept;
+
+    // Handle-only adds: the resting order is not entered into the OrderId
+    // index and is reachable only through AddSummary::handle, so adding,
+    // filling and cancelling it never touch the hash index.
+    template <OrderType Type = OrderType::LIMIT, typename FillSink>
+    [[nodiscard]] AddSummary add_order_handle(price_type price, quantity_type quantity, Side side, FillSink&& sink);
+    [[nodiscard]] AddSummary add_order_handle(
+        price_type price, quantity_type quantity, Side side, fill_type* fills, std::size_t capacity) noexcept;
     [[nodiscard]] bool cancel_order(OrderId order_id);
-    [[nodiscard]] bool modify_order(OrderId order_id, Quantity new_quantity);
+    [[nodiscard]] bool modify_order(OrderId order_id, quantity_type new_quantity);
+
+    // Handle overloads work for any resting order; stale handles return false.
+    [[nodiscard]] bool cancel_order(OrderHandle handle) noexcept;
+    [[nodiscard]] bool modify_order(OrderHandle handle, quantity_type new_quantity) noexcept;
+
+    // Cancel/replace in place: the same Order object (and so the same id and
+    // handle) is re-priced and/or re-sized. new_quantity is the new total
+    // including anything already filled, as in modify_order.
+    // - Same price, quantity not increased: keeps time priority
+    // - Price change or quantity increase: moves to the back of the queue at
+    //   the new price, matching first if the new price crosses
+    // - new_quantity at or below the filled quantity cancels the order
+    // Returns order_id 0 for unknown orders or invalid prices (the order is
+    // left untouched); otherwise handle is {0, 0} unless the order rests.
+    template <typename FillSink>
+    [[nodiscard]] AddSummary replace_order(
+        OrderId order_id, price_type new_price, quantity_type new_quantity, FillSink&& sink);
+    template <typename FillSink>
+    [[nodiscard]] AddSummary replace_order(
+        OrderHandle handle, price_type new_price, quantity_type new_quantity, FillSink&& sink);
+    [[nodiscard]] AddResult replace_order(OrderId order_id, price_type new_price, quantity_type new_quantity);
+
+    // Visit every resting order as fn(OrderId, Side, price, quantity,
+    // remaining): bids best to worst, then asks best to worst, each level in
+    // queue order. Restoring the orders in visit order rebuilds the book with
+    // the same priorities.
+    template <typename Fn>
+    void for_each_order(Fn&& fn) const;
 
-    [[nodiscard]] std::optional<Price> get_best_bid() const;
-    [[nodiscard]] std::optional<Price> get_best_ask() const;
-    [[nodiscard]] std::optional<Price> get_spread() const;
-    [[nodiscard]] std::optional<Price> get_mid_price() const;
+    // Rest an order captured from another book at the back of its level,
+    // without matching. `quantity` is its original size and `remaining` what
+    // is still open, so later modifies see the same filled amount. Returns
+    // order_id 0 for invalid prices, remaining of 0 or above quantity, or an
+    // order that would cross.
+    [[nodiscard]] AddSummary restore_order(
+        price_type price, quantity_type quantity, quantity_type remaining, Side side);
 
-    [[nodiscard]] Quantity get_bid_quantity_at_top() const;
-    [[nodiscard]] Quantity get_ask_quantity_at_top() const;
+    // Apply `count` commands in order, software-pipelined: while command i
+    // executes, the index slots, orders, levels and queue neighbours of the
+    // next few commands are prefetched. Results match issuing the commands
+    // one by one through the id-based calls. ResultSink provides
+    //   void on_fill(const fill_type&);
+    //   void on_result(std::size_t index, const AddSummary&);
+    // and gets one on_result per command, after that command's fills.
+    // Rejected or unknown commands report order_id 0; cancels and modifies
+    // report the order's remaining quantity and handle after the change.
+    template <typename ResultSink>
+    void apply_batch(const command_type* commands, std::size_t count, ResultSink& sink);
+
+    [[nodiscard]] std::optional<price_type> get_best_bid() const;
+    [[nodiscard]] std::optional<price_type> get_best_ask() const;
+    [[nodiscard]] std::optional<price_type> get_spread() const;
+    [[nodiscard]] std::optional<price_type> get_mid_price() const;
+
+    [[nodiscard]] quantity_type get_bid_quantity_at_top() const;
+    [[nodiscard]] quantity_type get_ask_quantity_at_top() const;
+
+    // Resting quantity at exactly `price`; 0 for empty or off-tick prices.
+    [[nodiscard]] quantity_type get_bid_quantity_at(price_type price) const noexcept;
+    [[nodiscard]] quantity_type get_ask_quantity_at(price_type price) const noexcept;
 
     [[nodiscard]] size_t get_bid_levels() const noexcept;
     [[nodiscard]] size_t get_ask_levels() const noexcept;
-    [[nodiscard]] size_t get_total_orders() const noexcept { return orders_.size(); }
+    [[nodiscard]] size_t get_total_orders() const noexcept {
+        return orders_.size() + unindexed_orders_;
+    }
 
-    struct BookSnapshot {
-        struct Level {
-            Price price;
-            Quantity quantity;
-            size_t order_count;
-        };
-        std::vector<Level> bids;
-        std::vector<Level> asks;
-    };
-    
+    // Bytes held by this book, excluding a shared arena.
+    [[nodiscard]] std::size_t memory_usage() const noexcept;
+
+    // Fault in the reserved order and level storage now rather than on
+    // first use (pools hand out slots lazily). A shared arena is left to
+    // its owner.
+    void prefault() noexcept {
+        order_store_.prefault();
+        own_level_pool_.prefault();
+    }
+
+    // Return spare index and overflow capacity after a burst of activity.
+    // Growth-disabled policies keep their pre-sized overflow stores.
+    void shrink_to_fit();
+
+    // Uses the top-N cache when depth <= Policy::kTopLevels.
     [[nodiscard]] BookSnapshot get_snapshot(size_t depth = 5) const;
+
+    // Allocation-free copy of the cached top levels (always empty when the
+    // policy leaves kTopLevels at 0).
+    void get_top_snapshot(TopSnapshot& out) const noexcept;
+
+    // Cumulative depth: total resting quantity from the best level through
+    // `price` inclusive (bids at or above it, asks at or below it).
+    [[nodiscard]] std::uint64_t get_bid_depth(price_type price) const noexcept;
+    [[nodiscard]] std::uint64_t get_ask_depth(price_type price) const noexcept;
+
+    // get_bid_sweep: selling into the bids; get_ask_sweep: buying the asks.
+    [[nodiscard]] SweepQuote get_bid_sweep(std::uint64_t quantity) const noexcept;
+    [[nodiscard]] SweepQuote get_ask_sweep(std::uint64_t quantity) const noexcept;
 };
 
+// The general-purpose book: 64-bit prices and quantities, unbounded band.
+using OrderBook = BasicOrderBook<DefaultBookPolicy>;
+
 }
 
+#include "order_book_impl.hpp"
+
 #endif
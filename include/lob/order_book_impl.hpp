@@ -0,0 +1,1454 @@
+#ifndef LOB_ORDER_BOOK_IMPL_HPP
+#define LOB_ORDER_BOOK_IMPL_HPP
+
+// Member definitions for BasicOrderBook. Included from order_book.hpp only;
+// the default policy is instantiated once in src/order_book.cpp.
+
+namespace lob {
+
+namespace detail {
+
+// Overflow stores are sorted worst to best: bids ascending, asks descending.
+template<Side S>
+constexpr bool worse_than(Price lhs, Price rhs) noexcept {
+    if constexpr (S == Side::BUY) {
+        return lhs < rhs;
+    } else {
+        return lhs > rhs;
+    }
+}
+
+template<Side S, typename Level>
+typename std::vector<Level*>::const_iterator overflow_lower_bound(
+    const std::vector<Level*>& overflow, Price price) noexcept {
+    return std::lower_bound(overflow.begin(), overflow.end(), price,
+        [](const Level* level, Price p) { return worse_than<S>(level->price, p); });
+}
+
+}  // namespace detail
+
+template <typename Policy>
+BasicOrderBook<Policy>::BasicOrderBook(Price tick_size, Arena* arena)
+    : tick_scale_(tick_size)
+    , bid_ladder_{}
+    , ask_ladder_{}
+    , window_lo_(-static_cast<Price>(kWindowTicks / 2))
+    , highest_buy_(nullptr)
+    , lowest_sell_(nullptr)
+    , bid_top_{}
+    , ask_top_{}
+    , level_pool_(&own_level_pool_)
+    , next_order_id_(1)
+    , unindexed_orders_(0) {
+    orders_.reserve(Policy::kOrderCapacity);
+    if constexpr (!Policy::kAllowGrowth) {
+        orders_.set_allow_growth(false);
+    }
+
+    if (arena) {
+        // Sized and configured by the arena's owner.
+        if constexpr (!Policy::kCompactOrders) {
+            order_store_.use_arena(arena->orders);
+        }
+        level_pool_ = &arena->levels;
+    } else {
+        order_store_.set_page_options(Policy::kPageOptions);
+        level_pool_->set_page_options(Policy::kPageOptions);
+        order_store_.reserve(Policy::kOrderCapacity);
+        if constexpr (!kSingleWindow) {
+            level_pool_->reserve(Policy::kLevelCapacity);
+        }
+        if constexpr (!Policy::kAllowGrowth) {
+            order_store_.set_allow_growth(false);
+            level_pool_->set_allow_growth(false);
+        }
+    }
+
+    bid_active_.assign(kWindowTicks);
+    ask_active_.assign(kWindowTicks);
+    if constexpr (Policy::kDepthIndex) {
+        bid_depth_.assign(kWindowTicks);
+        ask_depth_.assign(kWindowTicks);
+    }
+    if constexpr (kSingleWindow) {
+        // Anchor on the tick at or below the band floor.
+        const Price tick = scale().tick_size();
+        const Price min_price = Policy::kMinPrice;
+        window_lo_ = min_price / tick - ((min_price % tick) < 0 ? 1 : 0);
+    } else {
+        bid_overflow_.reserve(Policy::kOverflowLevels);
+        ask_overflow_.reserve(Policy::kOverflowLevels);
+    }
+}
+
+template <typename Policy>
+BasicOrderBook<Policy>::~BasicOrderBook() { clear(); }
+
+template <typename Policy>
+template<Side S, typename Sink>
+bool BasicOrderBook<Policy>::match_order_impl(
+    order_type* incoming, OrderId incoming_id, Sink& sink, std::size_t& fill_count) {
+    while (!incoming->is_filled()) {
+        level_type*& best = (S == Side::BUY) ? lowest_sell_ : highest_buy_;
+        if (!best) break;
+
+        level_type* contra_level = best;
+        constexpr Side kContra = (S == Side::BUY) ? Side::SELL : Side::BUY;
+
+        if constexpr (S == Side::BUY) {
+            if (LOB_UNLIKELY(incoming->price < contra_level->price)) break;
+        } else {
+            if (LOB_UNLIKELY(incoming->price > contra_level->price)) break;
+        }
+
+        // Depth index is updated once per level rather than per fill.
+        quantity_type level_filled = 0;
+        while (!incoming->is_filled() && !contra_level->is_empty()) {
+            if constexpr (is_bounded_sink<Sink>::value) {
+                if (LOB_UNLIKELY(sink.full())) {
+                    level_changed<kContra>(contra_level, -static_cast<int64_t>(level_filled));
+                    return true;
+                }
+            }
+
+            order_type* resting = contra_level->front();
+            const quantity_type fill_qty = std::min(incoming->remaining_quantity, resting->remaining_quantity);
+
+            if constexpr (S == Side::BUY) {
+                sink(fill_type{incoming_id, order_store_.id(resting), to_price(contra_level->price), fill_qty});
+            } else {
+                sink(fill_type{order_store_.id(resting), incoming_id, to_price(contra_level->price), fill_qty});
+            }
+            ++fill_count;
+            incoming->fill(fill_qty);
+            resting->fill(fill_qty);
+            contra_level->update_quantity(-static_cast<int64_t>(fill_qty));
+            level_filled += fill_qty;
+
+            if (LOB_LIKELY(resting->is_filled())) {
+                contra_level->pop_front(order_store_);
+                unindex(resting);
+                order_store_.destroy(resting);
+            }
+        }
+
+        level_changed<kContra>(contra_level, -static_cast<int64_t>(level_filled));
+        if (LOB_LIKELY(contra_level->is_empty())) {
+            erase_level<kContra>(contra_level);
+        }
+    }
+    return false;
+}
+
+template <typename Policy>
+template<bool Indexed, OrderType Type, typename Sink>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::add_order_impl(
+    price_type price, quantity_type quantity, Side side, Sink& sink) {
+    constexpr bool kRests = Type == OrderType::LIMIT || Type == OrderType::POST_ONLY ||
+                            Type == OrderType::POST_ONLY_SLIDE;
+    constexpr bool kPostOnly = Type == OrderType::POST_ONLY || Type == OrderType::POST_ONLY_SLIDE;
+
+    Price ticks;
+    if constexpr (Type == OrderType::MARKET) {
+        // Priced through the whole opposite side, so every level crosses.
+        ticks = (side == Side::BUY) ? std::numeric_limits<price_type>::max()
+                                    : std::numeric_limits<price_type>::min();
+    } else {
+        if constexpr (kBounded) {
+            if (LOB_UNLIKELY(price < Policy::kMinPrice || price > Policy::kMaxPrice)) {
+                return AddSummary{0, 0, 0, false, {0, 0}};
+            }
+        }
+        if (LOB_UNLIKELY(!scale().to_ticks(price, ticks))) {
+            return AddSummary{0, 0, 0, false, {0, 0}};
+        }
+    }
+
+    if constexpr (Type == OrderType::FOK) {
+        const std::size_t room = sink_room(sink);
+        const bool fillable = (side == Side::BUY)
+            ? can_fill<Side::BUY>(ticks, quantity, room)
+            : can_fill<Side::SELL>(ticks, quantity, room);
+        if (!fillable) {
+            return AddSummary{0, 0, 0, false, {0, 0}};
+        }
+    }
+
+    if constexpr (kPostOnly) {
+        const bool crosses = (side == Side::BUY)
+            ? (lowest_sell_ && ticks >= lowest_sell_->price)
+            : (highest_buy_ && ticks <= highest_buy_->price);
+        if (crosses) {
+            if constexpr (Type == OrderType::POST_ONLY) {
+                return AddSummary{0, 0, 0, false, {0, 0}};
+            } else {
+                ticks = (side == Side::BUY) ? Price{lowest_sell_->price} - 1 : Price{highest_buy_->price} + 1;
+                if constexpr (kBounded) {
+                    const Price slid = scale().to_price(ticks);
+                    if (slid < Policy::kMinPrice || slid > Policy::kMaxPrice) {
+                        return AddSummary{0, 0, 0, false, {0, 0}};
+                    }
+                }
+            }
+        }
+    }
+
+    if constexpr (!kRests) {
+        const OrderId order_id = next_order_id_++;
+        order_type incoming = order_store_type::transient(order_id, static_cast<price_type>(ticks), quantity, side);
+        std::size_t fill_count = 0;
+        const bool truncated = (side == Side::BUY)
+            ? match_order_impl<Side::BUY>(&incoming, order_id, sink, fill_count)
+            : match_order_impl<Side::SELL>(&incoming, order_id, sink, fill_count);
+        return AddSummary{order_id, incoming.remaining_quantity, fill_count, truncated, {0, 0}};
+    } else {
+        if constexpr (Indexed) {
+            if (LOB_UNLIKELY(orders_.full())) {
+                return AddSummary{0, 0, 0, false, {0, 0}};
+            }
+        }
+
+        const OrderId order_id = next_order_id_++;
+        order_type* order_ptr = order_store_.create(order_id, static_cast<price_type>(ticks), quantity, side, Indexed);
+        if (LOB_UNLIKELY(!order_ptr)) {
+            return AddSummary{0, 0, 0, false, {0, 0}};
+        }
+
+        std::size_t fill_count = 0;
+        bool truncated = false;
+        if constexpr (!kPostOnly) {
+            truncated = (side == Side::BUY)
+                ? match_order_impl<Side::BUY>(order_ptr, order_id, sink, fill_count)
+                : match_order_impl<Side::SELL>(order_ptr, order_id, sink, fill_count);
+        }
+
+        const quantity_type remaining = order_ptr->remaining_quantity;
+        OrderHandle handle{0, 0};
+        const bool rests = !order_ptr->is_filled() && LOB_LIKELY(!truncated);
+        const bool rested = rests && ((side == Side::BUY)
+            ? add_order_to_book_impl<Side::BUY>(order_ptr)
+            : add_order_to_book_impl<Side::SELL>(order_ptr));
+        if (LOB_LIKELY(rested)) {
+            if constexpr (Indexed) {
+                orders_.insert(order_id, order_ptr);
+            } else {
+                ++unindexed_orders_;
+            }
+            handle = handle_of(order_ptr);
+        } else {
+            order_store_.destroy(order_ptr);
+        }
+
+        return AddSummary{order_id, remaining, fill_count, truncated, handle};
+    }
+}
+
+// Read-only FOK pre-check: walks the opposite side from the touch until the
+// crossing volume covers `quantity`, counting the fills that would be needed.
+template <typename Policy>
+template<Side S>
+bool BasicOrderBook<Policy>::can_fill(Price ticks, quantity_type quantity, std::size_t max_fills) const noexcept {
+    constexpr Side kContra = (S == Side::BUY) ? Side::SELL : Side::BUY;
+    const level_type* level = (S == Side::BUY) ? lowest_sell_ : highest_buy_;
+    std::size_t fills = 0;
+    while (level) {
+        if constexpr (S == Side::BUY) {
+            if (ticks < level->price) return false;
+        } else {
+            if (ticks > level->price) return false;
+        }
+
+        if (level->total_volume < quantity) {
+            quantity -= level->total_volume;
+            fills += level->order_count();
+            if (fills > max_fills) return false;
+        } else {
+            for (const order_type* order = level->head_order; order; order = order_store_.next(order)) {
+                if (++fills > max_fills) return false;
+                if (order->remaining_quantity >= quantity) return true;
+                quantity -= order->remaining_quantity;
+            }
+            return true;
+        }
+        level = next_level<kContra>(level->price);
+    }
+    return false;
+}
+
+template <typename Policy>
+template <OrderType Type, typename FillSink>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::add_order(
+    price_type price, quantity_type quantity, Side side, FillSink&& sink) {
+    return add_order_impl<true, Type>(price, quantity, side, sink);
+}
+
+template <typename Policy>
+template <OrderType Type, typename FillSink>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::add_order_handle(
+    price_type price, quantity_type quantity, Side side, FillSink&& sink) {
+    return add_order_impl<false, Type>(price, quantity, side, sink);
+}
+
+template <typename Policy>
+template <OrderType Type>
+typename BasicOrderBook<Policy>::AddResult BasicOrderBook<Policy>::add_order(
+    price_type price, quantity_type quantity, Side side) {
+    AddResult result{0, {}, 0, {0, 0}};
+    auto collect = [&result](const fill_type& fill) { result.fills.push_back(fill); };
+    const AddSummary summary = add_order_impl<true, Type>(price, quantity, side, collect);
+    result.order_id = summary.order_id;
+    result.remaining_quantity = summary.remaining_quantity;
+    result.handle = summary.handle;
+    return result;
+}
+
+template <typename Policy>
+template <OrderType Type>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::add_order(
+    price_type price, quantity_type quantity, Side side, fill_type* fills, std::size_t capacity) noexcept {
+    SpanFillSink sink{fills, capacity, 0};
+    return add_order_impl<true, Type>(price, quantity, side, sink);
+}
+
+// Level helpers below take tick numbers, as stored in Order/PriceLevel::price.
+
+// Best level strictly worse than `price` inside the window, following the
+// circular slot order and stopping at the window edge.
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::level_type* BasicOrderBook<Policy>::window_next_level(Price price) const noexcept {
+    const Price lo = window_lo_;
+    const Price hi = window_hi();
+    if constexpr (S == Side::BUY) {
+        const Price from = std::min(price - 1, hi);
+        if (from < lo) {
+            return nullptr;
+        }
+        const std::size_t start = ladder_index(from);
+        auto slot = bid_active_.find_prev(start);
+        std::size_t distance;
+        if (slot) {
+            distance = start - *slot;
+        } else {
+            slot = bid_active_.find_prev(kWindowMask);
+            if (!slot) {
+                return nullptr;
+            }
+            distance = start + kWindowTicks - *slot;
+        }
+        if (static_cast<std::size_t>(from - lo) < distance) {
+            return nullptr;
+        }
+        return ladder_level<Side::BUY>(*slot);
+    } else {
+        const Price from = std::max(price + 1, lo);
+        if (from > hi) {
+            return nullptr;
+        }
+        const std::size_t start = ladder_index(from);
+        auto slot = ask_active_.find_next(start);
+        std::size_t distance;
+        if (slot) {
+            distance = *slot - start;
+        } else {
+            slot = ask_active_.find_next(0);
+            if (!slot) {
+                return nullptr;
+            }
+            distance = *slot + kWindowTicks - start;
+        }
+        if (static_cast<std::size_t>(hi - from) < distance) {
+            return nullptr;
+        }
+        return ladder_level<Side::SELL>(*slot);
+    }
+}
+
+// Best level strictly worse than `price`, across window and overflow.
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::level_type* BasicOrderBook<Policy>::next_level(Price price) const noexcept {
+    level_type* in_window_level = window_next_level<S>(price);
+    if constexpr (kSingleWindow) {
+        return in_window_level;
+    } else {
+        const auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+        const auto pos = detail::overflow_lower_bound<S>(overflow, price);
+        level_type* overflow_level = (pos == overflow.begin()) ? nullptr : *(pos - 1);
+
+        if (!overflow_level) {
+            return in_window_level;
+        }
+        if (!in_window_level) {
+            return overflow_level;
+        }
+        return detail::worse_than<S>(overflow_level->price, in_window_level->price) ? in_window_level : overflow_level;
+    }
+}
+
+// The window follows the touch: a price outside it that is still within half
+// a window of the market re-centers the window there. Prices further out
+// stay in overflow so a stray far order cannot drag the window off-market.
+template <typename Policy>
+void BasicOrderBook<Policy>::maybe_recenter(Price price) {
+    Price center = price;
+    if (highest_buy_ && lowest_sell_) {
+        center = highest_buy_->price + (Price{lowest_sell_->price} - highest_buy_->price) / 2;
+    } else if (highest_buy_) {
+        center = highest_buy_->price;
+    } else if (lowest_sell_) {
+        center = lowest_sell_->price;
+    }
+
+    const Price half = static_cast<Price>(kWindowTicks / 2);
+    if (price - center >= half || center - price >= half) {
+        return;
+    }
+
+    if constexpr (!Policy::kAllowGrowth) {
+        // Evicted levels must fit in the pre-sized overflow stores.
+        const std::size_t bid_levels = bid_active_.count() + bid_overflow_.size();
+        const std::size_t ask_levels = ask_active_.count() + ask_overflow_.size();
+        if (bid_levels > bid_overflow_.capacity() || ask_levels > ask_overflow_.capacity() ||
+            bid_levels + ask_levels > level_pool_->capacity()) {
+            return;
+        }
+    }
+
+    const Price best_bid = highest_buy_ ? Price{highest_buy_->price} : 0;
+    const Price best_ask = lowest_sell_ ? Price{lowest_sell_->price} : 0;
+
+    window_lo_ = center - half;
+    evict_outside_window<Side::BUY>();
+    evict_outside_window<Side::SELL>();
+    migrate_into_window<Side::BUY>();
+    migrate_into_window<Side::SELL>();
+
+    // Level headers moved between ladder and overflow.
+    if (highest_buy_) {
+        highest_buy_ = level_at<Side::BUY>(best_bid);
+    }
+    if (lowest_sell_) {
+        lowest_sell_ = level_at<Side::SELL>(best_ask);
+    }
+}
+
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::evict_outside_window() {
+    auto& ladder = (S == Side::BUY) ? bid_ladder_ : ask_ladder_;
+    auto& active = (S == Side::BUY) ? bid_active_ : ask_active_;
+    auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+
+    for (auto slot = active.find_next(0); slot; slot = active.find_next(*slot + 1)) {
+        const level_type& level = ladder[*slot];
+        if (in_window(level.price)) {
+            continue;
+        }
+        if constexpr (Policy::kDepthIndex) {
+            auto& depth = (S == Side::BUY) ? bid_depth_ : ask_depth_;
+            depth.add(*slot, -static_cast<std::int64_t>(level.total_volume), level.price);
+        }
+        // Capacity was checked by maybe_recenter.
+        level_type* moved = level_pool_->create(level);
+        active.clear(*slot);
+        overflow.insert(detail::overflow_lower_bound<S>(overflow, moved->price), moved);
+    }
+}
+
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::migrate_into_window() {
+    auto& ladder = (S == Side::BUY) ? bid_ladder_ : ask_ladder_;
+    auto& active = (S == Side::BUY) ? bid_active_ : ask_active_;
+    auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+
+    // In-window prices form one contiguous run of the sorted store.
+    const Price worst = (S == Side::BUY) ? window_lo_ : window_hi();
+    const auto first = detail::overflow_lower_bound<S>(overflow, worst);
+    auto last = first;
+    while (last != overflow.end() && in_window((*last)->price)) {
+        const std::size_t idx = ladder_index((*last)->price);
+        ladder[idx] = **last;
+        active.set(idx);
+        track_depth<S>(&ladder[idx], static_cast<std::int64_t>(ladder[idx].total_volume));
+        level_pool_->destroy(*last);
+        ++last;
+    }
+    overflow.erase(first, last);
+}
+
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::level_type* BasicOrderBook<Policy>::create_overflow_level(Price price) {
+    auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+    const auto pos = detail::overflow_lower_bound<S>(overflow, price);
+    if (pos != overflow.end() && (*pos)->price == price) {
+        return *pos;
+    }
+
+    if constexpr (!Policy::kAllowGrowth) {
+        if (LOB_UNLIKELY(overflow.size() == overflow.capacity())) {
+            return nullptr;
+        }
+    }
+    level_type* level = level_pool_->create(static_cast<price_type>(price));
+    if (LOB_UNLIKELY(!level)) {
+        return nullptr;
+    }
+    overflow.insert(pos, level);
+    return level;
+}
+
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::level_type* BasicOrderBook<Policy>::find_or_create_level(Price price) {
+    auto& ladder = (S == Side::BUY) ? bid_ladder_ : ask_ladder_;
+    auto& active = (S == Side::BUY) ? bid_active_ : ask_active_;
+    auto*& best  = (S == Side::BUY) ? highest_buy_ : lowest_sell_;
+
+    level_type* level;
+    if constexpr (!kSingleWindow) {
+        if (LOB_UNLIKELY(!in_window(price))) {
+            maybe_recenter(price);
+            if (!in_window(price)) {
+                level = create_overflow_level<S>(price);
+                if (LOB_UNLIKELY(!level)) {
+                    return nullptr;
+                }
+                if (!best || detail::worse_than<S>(best->price, price)) {
+                    best = level;
+                }
+                return level;
+            }
+        }
+    }
+
+    const std::size_t idx = ladder_index(price);
+    level = &ladder[idx];
+    if (LOB_LIKELY(active.test(idx))) {
+        return level;
+    }
+    *level = level_type(static_cast<price_type>(price));
+    active.set(idx);
+
+    if (!best || detail::worse_than<S>(best->price, price)) {
+        best = level;
+    }
+    return level;
+}
+
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::erase_level(level_type* level) noexcept {
+    auto*& best = (S == Side::BUY) ? highest_buy_ : lowest_sell_;
+    const Price price = level->price;
+    const bool windowed = in_window(price);
+
+    if (LOB_LIKELY(windowed)) {
+        auto& active = (S == Side::BUY) ? bid_active_ : ask_active_;
+        active.clear(ladder_index(price));
+    } else {
+        auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+        overflow.erase(detail::overflow_lower_bound<S>(overflow, price));
+    }
+
+    if (level == best) {
+        best = next_level<S>(price);
+    }
+    erase_top<S>(price);
+    if (LOB_UNLIKELY(!windowed)) {
+        level_pool_->destroy(level);
+    }
+}
+
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::level_type* BasicOrderBook<Policy>::ladder_level(std::size_t idx) const noexcept {
+    const Ladder& ladder = (S == Side::BUY) ? bid_ladder_ : ask_ladder_;
+    return const_cast<level_type*>(&ladder[idx]);
+}
+
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::level_type* BasicOrderBook<Policy>::level_at(Price price) const noexcept {
+    if constexpr (!kSingleWindow) {
+        if (LOB_UNLIKELY(!in_window(price))) {
+            const auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+            return *detail::overflow_lower_bound<S>(overflow, price);
+        }
+    }
+    return ladder_level<S>(ladder_index(price));
+}
+
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::level_type* BasicOrderBook<Policy>::level_of(const order_type* order) const noexcept {
+    return level_at<S>(order->price);
+}
+
+template <typename Policy>
+template<Side S>
+bool BasicOrderBook<Policy>::add_order_to_book_impl(order_type* order) {
+    level_type* level = find_or_create_level<S>(order->price);
+    if (LOB_UNLIKELY(!level)) {
+        return false;
+    }
+    level->add_order(order, order_store_);
+    level_changed<S>(level, static_cast<std::int64_t>(order->remaining_quantity));
+    return true;
+}
+
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::remove_order_from_book_impl(order_type* order) {
+    level_type* level = level_of<S>(order);
+    const std::int64_t volume_delta = -static_cast<std::int64_t>(order->remaining_quantity);
+    level->remove_order(order, order_store_);
+    level_changed<S>(level, volume_delta);
+    if (level->is_empty()) {
+        erase_level<S>(level);
+    }
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::AddResult BasicOrderBook<Policy>::add_order(
+    price_type price, quantity_type quantity, Side side) {
+    return add_order<OrderType::LIMIT>(price, quantity, side);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::add_order(
+    price_type price, quantity_type quantity, Side side, fill_type* fills, std::size_t capacity) noexcept {
+    SpanFillSink sink{fills, capacity, 0};
+    return add_order_impl<true, OrderType::LIMIT>(price, quantity, side, sink);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::add_order_handle(
+    price_type price, quantity_type quantity, Side side, fill_type* fills, std::size_t capacity) noexcept {
+    SpanFillSink sink{fills, capacity, 0};
+    return add_order_impl<false, OrderType::LIMIT>(price, quantity, side, sink);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::order_type* BasicOrderBook<Policy>::resolve(OrderHandle handle) const noexcept {
+    return order_store_.resolve(handle);
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::unindex(const order_type* order) noexcept {
+    if (LOB_LIKELY(order_store_.indexed(order))) {
+        orders_.erase(order_store_.id(order));
+    } else {
+        --unindexed_orders_;
+    }
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::cancel_resting(order_type* order) noexcept {
+    if (order->side == Side::BUY) {
+        remove_order_from_book_impl<Side::BUY>(order);
+    } else {
+        remove_order_from_book_impl<Side::SELL>(order);
+    }
+    order_store_.destroy(order);
+}
+
+template <typename Policy>
+bool BasicOrderBook<Policy>::cancel_order(OrderId order_id) {
+    order_type* order = orders_.extract(order_id);
+    if (LOB_UNLIKELY(!order)) {
+        return false;
+    }
+    cancel_resting(order);
+    return true;
+}
+
+template <typename Policy>
+bool BasicOrderBook<Policy>::cancel_order(OrderHandle handle) noexcept {
+    order_type* order = resolve(handle);
+    if (LOB_UNLIKELY(!order)) {
+        return false;
+    }
+    unindex(order);
+    cancel_resting(order);
+    return true;
+}
+
+template <typename Policy>
+bool BasicOrderBook<Policy>::modify_order(OrderId order_id, quantity_type new_quantity) {
+    order_type* order = orders_.find(order_id);
+    if (LOB_UNLIKELY(!order)) {
+        return false;
+    }
+    modify_resting(order, new_quantity);
+    return true;
+}
+
+template <typename Policy>
+bool BasicOrderBook<Policy>::modify_order(OrderHandle handle, quantity_type new_quantity) noexcept {
+    order_type* order = resolve(handle);
+    if (LOB_UNLIKELY(!order)) {
+        return false;
+    }
+    modify_resting(order, new_quantity);
+    return true;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::modify_resting(order_type* order, quantity_type new_quantity) noexcept {
+    const quantity_type filled_qty = order_store_.quantity(order) - order->remaining_quantity;
+    const quantity_type new_remaining = (new_quantity > filled_qty) ? (new_quantity - filled_qty) : 0;
+
+    const int64_t qty_diff = static_cast<int64_t>(new_remaining) - static_cast<int64_t>(order->remaining_quantity);
+    if (order->side == Side::BUY) {
+        level_type* level = level_of<Side::BUY>(order);
+        level->update_quantity(qty_diff);
+        level_changed<Side::BUY>(level, qty_diff);
+    } else {
+        level_type* level = level_of<Side::SELL>(order);
+        level->update_quantity(qty_diff);
+        level_changed<Side::SELL>(level, qty_diff);
+    }
+
+    order_store_.set_quantity(order, new_quantity);
+    order->remaining_quantity = new_remaining;
+}
+
+template <typename Policy>
+template <typename Sink>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::replace_resting(
+    order_type* order, price_type new_price, quantity_type new_quantity, Sink& sink) {
+    if constexpr (kBounded) {
+        if (LOB_UNLIKELY(new_price < Policy::kMinPrice || new_price > Policy::kMaxPrice)) {
+            return AddSummary{0, 0, 0, false, {0, 0}};
+        }
+    }
+    Price ticks;
+    if (LOB_UNLIKELY(!scale().to_ticks(new_price, ticks))) {
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+
+    const OrderId order_id = order_store_.id(order);
+    const quantity_type filled_qty = order_store_.quantity(order) - order->remaining_quantity;
+    if (new_quantity <= filled_qty) {
+        unindex(order);
+        cancel_resting(order);
+        return AddSummary{order_id, 0, 0, false, {0, 0}};
+    }
+
+    const quantity_type new_remaining = new_quantity - filled_qty;
+    if (ticks == order->price && new_remaining <= order->remaining_quantity) {
+        modify_resting(order, new_quantity);
+        return AddSummary{order_id, new_remaining, 0, false, handle_of(order)};
+    }
+
+    // Loses priority: leave the old queue, re-price, and re-enter as if new.
+    const Side side = order->side;
+    if (side == Side::BUY) {
+        remove_order_from_book_impl<Side::BUY>(order);
+    } else {
+        remove_order_from_book_impl<Side::SELL>(order);
+    }
+    order->price = static_cast<price_type>(ticks);
+    order->remaining_quantity = new_remaining;
+    order_store_.set_quantity(order, new_quantity);
+    order_store_.restamp(order);
+
+    std::size_t fill_count = 0;
+    const bool truncated = (side == Side::BUY)
+        ? match_order_impl<Side::BUY>(order, order_id, sink, fill_count)
+        : match_order_impl<Side::SELL>(order, order_id, sink, fill_count);
+
+    const quantity_type remaining = order->remaining_quantity;
+    const bool rests = !order->is_filled() && LOB_LIKELY(!truncated);
+    const bool rested = rests && ((side == Side::BUY)
+        ? add_order_to_book_impl<Side::BUY>(order)
+        : add_order_to_book_impl<Side::SELL>(order));
+    if (LOB_LIKELY(rested)) {
+        return AddSummary{order_id, remaining, fill_count, truncated, handle_of(order)};
+    }
+    unindex(order);
+    order_store_.destroy(order);
+    return AddSummary{order_id, remaining, fill_count, truncated, {0, 0}};
+}
+
+template <typename Policy>
+template <typename FillSink>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::replace_order(
+    OrderId order_id, price_type new_price, quantity_type new_quantity, FillSink&& sink) {
+    order_type* order = orders_.find(order_id);
+    if (LOB_UNLIKELY(!order)) {
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+    return replace_resting(order, new_price, new_quantity, sink);
+}
+
+template <typename Policy>
+template <typename FillSink>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::replace_order(
+    OrderHandle handle, price_type new_price, quantity_type new_quantity, FillSink&& sink) {
+    order_type* order = resolve(handle);
+    if (LOB_UNLIKELY(!order)) {
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+    return replace_resting(order, new_price, new_quantity, sink);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::AddResult BasicOrderBook<Policy>::replace_order(
+    OrderId order_id, price_type new_price, quantity_type new_quantity) {
+    AddResult result{0, {}, 0, {0, 0}};
+    auto collect = [&result](const fill_type& fill) { result.fills.push_back(fill); };
+    const AddSummary summary = replace_order(order_id, new_price, new_quantity, collect);
+    result.order_id = summary.order_id;
+    result.remaining_quantity = summary.remaining_quantity;
+    result.handle = summary.handle;
+    return result;
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::prefetch_index(const command_type& cmd) const noexcept {
+    if (cmd.action != BookAction::ADD) {
+        orders_.prefetch(cmd.order_id);
+    }
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::order_type* BasicOrderBook<Policy>::prefetch_order(
+    const command_type& cmd) const noexcept {
+    if (cmd.action != BookAction::ADD) {
+        order_type* order = orders_.find(cmd.order_id);
+        if (order) {
+            LOB_PREFETCH_WRITE(order);
+        }
+        return order;
+    }
+    Price ticks;
+    if (scale().to_ticks(cmd.price, ticks) && in_window(ticks)) {
+        const Ladder& ladder = (cmd.side == Side::BUY) ? bid_ladder_ : ask_ladder_;
+        LOB_PREFETCH(&ladder[ladder_index(ticks)]);
+    }
+    return nullptr;
+}
+
+// `order` is what prefetch_order found. Commands run since may have freed
+// or recycled it; store blocks never move, so reading it is still safe and
+// at worst prefetches the wrong lines.
+template <typename Policy>
+void BasicOrderBook<Policy>::prefetch_neighbours(const command_type& cmd, const order_type* order) const noexcept {
+    if (cmd.action != BookAction::ADD) {
+        if (order) {
+            LOB_PREFETCH_WRITE((order->side == Side::BUY) ? level_of<Side::BUY>(order) : level_of<Side::SELL>(order));
+            LOB_PREFETCH_WRITE(order_store_.prev(order));
+            LOB_PREFETCH_WRITE(order_store_.next(order));
+        }
+        return;
+    }
+    // The level header itself came in with prefetch_order; its tail is
+    // where the new order links in.
+    Price ticks;
+    if (scale().to_ticks(cmd.price, ticks) && in_window(ticks)) {
+        const Ladder& ladder = (cmd.side == Side::BUY) ? bid_ladder_ : ask_ladder_;
+        const LevelBitmap& active = (cmd.side == Side::BUY) ? bid_active_ : ask_active_;
+        const std::size_t idx = ladder_index(ticks);
+        if (active.test(idx) && ladder[idx].tail_order) {
+            LOB_PREFETCH_WRITE(ladder[idx].tail_order);
+        }
+    }
+}
+
+// Live (odd generation) and still carrying the id means it is the order the
+// command names: ids are never reused, and during the batch no other book
+// draws on a shared arena. Anything else, including an order first seen
+// after the prefetch, goes through the index.
+template <typename Policy>
+typename BasicOrderBook<Policy>::order_type* BasicOrderBook<Policy>::recheck(
+    order_type* order, OrderId order_id) const noexcept {
+    if (LOB_LIKELY(order && order_store_.live(order) && order_store_.id(order) == order_id)) {
+        return order;
+    }
+    return orders_.find(order_id);
+}
+
+template <typename Policy>
+template <typename Sink>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::dispatch_add(
+    const command_type& cmd, Sink& sink) {
+    switch (cmd.type) {
+        case OrderType::MARKET:
+            return add_order_impl<true, OrderType::MARKET>(cmd.price, cmd.quantity, cmd.side, sink);
+        case OrderType::IOC:
+            return add_order_impl<true, OrderType::IOC>(cmd.price, cmd.quantity, cmd.side, sink);
+        case OrderType::FOK:
+            return add_order_impl<true, OrderType::FOK>(cmd.price, cmd.quantity, cmd.side, sink);
+        case OrderType::POST_ONLY:
+            return add_order_impl<true, OrderType::POST_ONLY>(cmd.price, cmd.quantity, cmd.side, sink);
+        case OrderType::POST_ONLY_SLIDE:
+            return add_order_impl<true, OrderType::POST_ONLY_SLIDE>(cmd.price, cmd.quantity, cmd.side, sink);
+        case OrderType::LIMIT:
+        default:
+            return add_order_impl<true, OrderType::LIMIT>(cmd.price, cmd.quantity, cmd.side, sink);
+    }
+}
+
+template <typename Policy>
+template <typename ResultSink>
+void BasicOrderBook<Policy>::apply_batch(const command_type* commands, std::size_t count, ResultSink& sink) {
+    constexpr std::size_t kOrderAhead = kPrefetchDistance / 2;
+    constexpr std::size_t kLevelAhead = kPrefetchDistance / 4;
+
+    auto on_fill = [&sink](const fill_type& fill) { sink.on_fill(fill); };
+
+    // Orders found by the order stage, by command index modulo the ring
+    // size; entries live from the order stage through execution.
+    static_assert(kOrderAhead < kPrefetchDistance, "order ring too small");
+    std::array<order_type*, kPrefetchDistance> found{};
+
+    // Prime the pipeline so the first commands get the later stages too.
+    for (std::size_t i = 0; i < std::min(count, kPrefetchDistance); ++i) {
+        prefetch_index(commands[i]);
+    }
+    for (std::size_t i = 0; i < std::min(count, kOrderAhead); ++i) {
+        found[i % kPrefetchDistance] = prefetch_order(commands[i]);
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        if (i + kPrefetchDistance < count) {
+            prefetch_index(commands[i + kPrefetchDistance]);
+        }
+        if (i + kOrderAhead < count) {
+            found[(i + kOrderAhead) % kPrefetchDistance] = prefetch_order(commands[i + kOrderAhead]);
+        }
+        if (i + kLevelAhead < count) {
+            prefetch_neighbours(commands[i + kLevelAhead], found[(i + kLevelAhead) % kPrefetchDistance]);
+        }
+
+        // Earlier commands in the batch may have filled, cancelled or
+        // replaced the order since it was found: recheck before use.
+        const command_type& cmd = commands[i];
+        order_type* const ahead = found[i % kPrefetchDistance];
+        AddSummary result{0, 0, 0, false, {0, 0}};
+        switch (cmd.action) {
+            case BookAction::ADD:
+                result = dispatch_add(cmd, on_fill);
+                break;
+            case BookAction::CANCEL:
+                if (order_type* order = recheck(ahead, cmd.order_id)) {
+                    unindex(order);
+                    cancel_resting(order);
+                    result.order_id = cmd.order_id;
+                }
+                break;
+            case BookAction::MODIFY:
+                if (order_type* order = recheck(ahead, cmd.order_id)) {
+                    const quantity_type filled_qty = order_store_.quantity(order) - order->remaining_quantity;
+                    result.order_id = cmd.order_id;
+                    result.remaining_quantity = (cmd.quantity > filled_qty) ? cmd.quantity - filled_qty : 0;
+                    result.handle = handle_of(order);
+                    modify_resting(order, cmd.quantity);
+                }
+                break;
+            case BookAction::REPLACE:
+                if (order_type* order = recheck(ahead, cmd.order_id)) {
+                    result = replace_resting(order, cmd.price, cmd.quantity, on_fill);
+                }
+                break;
+        }
+        sink.on_result(i, result);
+    }
+}
+
+template <typename Policy>
+std::optional<typename BasicOrderBook<Policy>::price_type> BasicOrderBook<Policy>::get_best_bid() const {
+    if (!highest_buy_) {
+        return std::nullopt;
+    }
+    return to_price(highest_buy_->price);
+}
+
+template <typename Policy>
+std::optional<typename BasicOrderBook<Policy>::price_type> BasicOrderBook<Policy>::get_best_ask() const {
+    if (!lowest_sell_) {
+        return std::nullopt;
+    }
+    return to_price(lowest_sell_->price);
+}
+
+template <typename Policy>
+std::optional<typename BasicOrderBook<Policy>::price_type> BasicOrderBook<Policy>::get_spread() const {
+    const auto bid = get_best_bid();
+    const auto ask = get_best_ask();
+    if (!bid || !ask) {
+        return std::nullopt;
+    }
+    return static_cast<price_type>(*ask - *bid);
+}
+
+template <typename Policy>
+std::optional<typename BasicOrderBook<Policy>::price_type> BasicOrderBook<Policy>::get_mid_price() const {
+    const auto bid = get_best_bid();
+    const auto ask = get_best_ask();
+    if (!bid || !ask) {
+        return std::nullopt;
+    }
+    return static_cast<price_type>((Price{*bid} + *ask) / 2);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::quantity_type BasicOrderBook<Policy>::get_bid_quantity_at_top() const {
+    return highest_buy_ ? highest_buy_->total_volume : 0;
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::quantity_type BasicOrderBook<Policy>::get_ask_quantity_at_top() const {
+    return lowest_sell_ ? lowest_sell_->total_volume : 0;
+}
+
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::quantity_type BasicOrderBook<Policy>::quantity_at(price_type price) const noexcept {
+    if constexpr (kBounded) {
+        if (price < Policy::kMinPrice || price > Policy::kMaxPrice) {
+            return 0;
+        }
+    }
+    Price ticks;
+    if (!scale().to_ticks(price, ticks)) {
+        return 0;
+    }
+    if (LOB_LIKELY(in_window(ticks))) {
+        const std::size_t idx = ladder_index(ticks);
+        const LevelBitmap& active = (S == Side::BUY) ? bid_active_ : ask_active_;
+        return active.test(idx) ? ladder_level<S>(idx)->total_volume : 0;
+    }
+    const auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+    const auto pos = detail::overflow_lower_bound<S>(overflow, ticks);
+    return (pos != overflow.end() && (*pos)->price == ticks) ? (*pos)->total_volume : 0;
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::quantity_type BasicOrderBook<Policy>::get_bid_quantity_at(price_type price) const noexcept {
+    return quantity_at<Side::BUY>(price);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::quantity_type BasicOrderBook<Policy>::get_ask_quantity_at(price_type price) const noexcept {
+    return quantity_at<Side::SELL>(price);
+}
+
+template <typename Policy>
+size_t BasicOrderBook<Policy>::get_bid_levels() const noexcept {
+    return bid_active_.count() + bid_overflow_.size();
+}
+
+template <typename Policy>
+size_t BasicOrderBook<Policy>::get_ask_levels() const noexcept {
+    return ask_active_.count() + ask_overflow_.size();
+}
+
+template <typename Policy>
+template <typename Fn>
+void BasicOrderBook<Policy>::for_each_order(Fn&& fn) const {
+    for (const level_type* level = highest_buy_; level; level = next_level<Side::BUY>(level->price)) {
+        for (const order_type* order = level->head_order; order; order = order_store_.next(order)) {
+            fn(order_store_.id(order), Side::BUY, to_price(level->price), order_store_.quantity(order),
+               order->remaining_quantity);
+        }
+    }
+    for (const level_type* level = lowest_sell_; level; level = next_level<Side::SELL>(level->price)) {
+        for (const order_type* order = level->head_order; order; order = order_store_.next(order)) {
+            fn(order_store_.id(order), Side::SELL, to_price(level->price), order_store_.quantity(order),
+               order->remaining_quantity);
+        }
+    }
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::AddSummary BasicOrderBook<Policy>::restore_order(
+    price_type price, quantity_type quantity, quantity_type remaining, Side side) {
+    if (LOB_UNLIKELY(remaining == 0 || remaining > quantity || orders_.full())) {
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+    if constexpr (kBounded) {
+        if (LOB_UNLIKELY(price < Policy::kMinPrice || price > Policy::kMaxPrice)) {
+            return AddSummary{0, 0, 0, false, {0, 0}};
+        }
+    }
+    Price ticks;
+    if (LOB_UNLIKELY(!scale().to_ticks(price, ticks))) {
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+    const bool crosses = (side == Side::BUY)
+        ? (lowest_sell_ && ticks >= lowest_sell_->price)
+        : (highest_buy_ && ticks <= highest_buy_->price);
+    if (crosses) {
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+
+    const OrderId order_id = next_order_id_++;
+    order_type* order = order_store_.create(order_id, static_cast<price_type>(ticks), quantity, side, true);
+    if (LOB_UNLIKELY(!order)) {
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+    order->remaining_quantity = remaining;
+    const bool rested = (side == Side::BUY)
+        ? add_order_to_book_impl<Side::BUY>(order)
+        : add_order_to_book_impl<Side::SELL>(order);
+    if (LOB_UNLIKELY(!rested)) {
+        order_store_.destroy(order);
+        return AddSummary{0, 0, 0, false, {0, 0}};
+    }
+    orders_.insert(order_id, order);
+    return AddSummary{order_id, remaining, 0, false, handle_of(order)};
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::BookSnapshot BasicOrderBook<Policy>::get_snapshot(size_t depth) const {
+    BookSnapshot snapshot;
+
+    if constexpr (kTopLevels != 0) {
+        if (depth <= kTopLevels) {
+            snapshot.bids.assign(bid_top_.levels.begin(), bid_top_.levels.begin() + std::min(depth, bid_top_.count));
+            snapshot.asks.assign(ask_top_.levels.begin(), ask_top_.levels.begin() + std::min(depth, ask_top_.count));
+            return snapshot;
+        }
+    }
+
+    for (const level_type* level = highest_buy_;
+         level && snapshot.bids.size() < depth;
+         level = next_level<Side::BUY>(level->price)) {
+        snapshot.bids.push_back({to_price(level->price), level->total_volume, level->order_count()});
+    }
+
+    for (const level_type* level = lowest_sell_;
+         level && snapshot.asks.size() < depth;
+         level = next_level<Side::SELL>(level->price)) {
+        snapshot.asks.push_back({to_price(level->price), level->total_volume, level->order_count()});
+    }
+
+    return snapshot;
+}
+
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::track_depth(const level_type* level, std::int64_t volume_delta) noexcept {
+    if constexpr (Policy::kDepthIndex) {
+        if (in_window(level->price)) {
+            auto& depth = (S == Side::BUY) ? bid_depth_ : ask_depth_;
+            depth.add(ladder_index(level->price), volume_delta, level->price);
+        }
+    }
+}
+
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::level_changed(const level_type* level, std::int64_t volume_delta) noexcept {
+    track_depth<S>(level, volume_delta);
+    refresh_top<S>(level);
+}
+
+// Update the level's cache entry, or insert it if it now ranks in the top N.
+// Only a newly created level can be missing from the cache while ranking.
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::refresh_top(const level_type* level) noexcept {
+    if constexpr (kTopLevels != 0) {
+        TopCache& cache = (S == Side::BUY) ? bid_top_ : ask_top_;
+        const Price price = level->price;
+        std::size_t pos = 0;
+        while (pos < cache.count && detail::worse_than<S>(price, cache.ticks[pos])) {
+            ++pos;
+        }
+        const typename BookSnapshot::Level entry{to_price(price), level->total_volume, level->order_count()};
+        if (pos < cache.count && cache.ticks[pos] == price) {
+            cache.levels[pos] = entry;
+            return;
+        }
+        if (pos == kTopLevels) {
+            return;
+        }
+        const std::size_t last = std::min(cache.count, kTopLevels - 1);
+        for (std::size_t i = last; i > pos; --i) {
+            cache.levels[i] = cache.levels[i - 1];
+            cache.ticks[i] = cache.ticks[i - 1];
+        }
+        cache.levels[pos] = entry;
+        cache.ticks[pos] = price;
+        cache.count = last + 1;
+    }
+}
+
+// Drop an erased level from the cache and pull in the next one behind the
+// cached run. Called once the level has left the ladder / overflow and the
+// best pointer has moved past it.
+template <typename Policy>
+template<Side S>
+void BasicOrderBook<Policy>::erase_top(Price price) noexcept {
+    if constexpr (kTopLevels != 0) {
+        TopCache& cache = (S == Side::BUY) ? bid_top_ : ask_top_;
+        std::size_t pos = 0;
+        while (pos < cache.count && cache.ticks[pos] != price) {
+            ++pos;
+        }
+        if (pos == cache.count) {
+            return;
+        }
+        const bool was_full = cache.count == kTopLevels;
+        for (std::size_t i = pos + 1; i < cache.count; ++i) {
+            cache.levels[i - 1] = cache.levels[i];
+            cache.ticks[i - 1] = cache.ticks[i];
+        }
+        --cache.count;
+        if (was_full) {
+            // An emptied cache refills from the side's (already updated)
+            // best level; otherwise from behind the last cached one.
+            const level_type* best = (S == Side::BUY) ? highest_buy_ : lowest_sell_;
+            if (const level_type* next = cache.count == 0 ? best : next_level<S>(cache.ticks[cache.count - 1])) {
+                cache.levels[cache.count] = {to_price(next->price), next->total_volume, next->order_count()};
+                cache.ticks[cache.count] = next->price;
+                ++cache.count;
+            }
+        }
+    }
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::get_top_snapshot(TopSnapshot& out) const noexcept {
+    out.bid_count = bid_top_.count;
+    out.ask_count = ask_top_.count;
+    std::copy_n(bid_top_.levels.begin(), bid_top_.count, out.bids.begin());
+    std::copy_n(ask_top_.levels.begin(), ask_top_.count, out.asks.begin());
+}
+
+// Sum over window ticks [first, last], which may wrap around the slot array.
+template <typename Policy>
+DepthIndex::Sum BasicOrderBook<Policy>::window_sum(const DepthIndex& depth, Price first, Price last) const noexcept {
+    const std::size_t lo = ladder_index(first);
+    const std::size_t hi = ladder_index(last);
+    const DepthIndex::Sum before = depth.prefix_before(lo);
+    DepthIndex::Sum upto = depth.prefix(hi);
+    if (lo > hi) {
+        const DepthIndex::Sum total = depth.total();
+        upto.volume += total.volume;
+        upto.notional += total.notional;
+    }
+    return DepthIndex::Sum{upto.volume - before.volume, upto.notional - before.notional};
+}
+
+// Sum from the window's lowest tick through `slot`, in tick order.
+template <typename Policy>
+DepthIndex::Sum BasicOrderBook<Policy>::logical_prefix(const DepthIndex& depth, std::size_t slot) const noexcept {
+    return window_sum(depth, window_lo_, window_lo_ + static_cast<Price>((slot - ladder_index(window_lo_)) & kWindowMask));
+}
+
+// Slot of the lowest tick whose cumulative window volume reaches `volume`
+// (1 <= volume <= total), counting up from the window's lowest tick.
+template <typename Policy>
+std::size_t BasicOrderBook<Policy>::logical_search(const DepthIndex& depth, std::uint64_t volume) const noexcept {
+    const std::size_t base = ladder_index(window_lo_);
+    const std::uint64_t before = depth.prefix_before(base).volume;
+    const std::uint64_t upper = depth.total().volume - before;
+    return upper >= volume ? depth.lower_bound(volume + before) : depth.lower_bound(volume - upper);
+}
+
+template <typename Policy>
+template<Side S>
+std::uint64_t BasicOrderBook<Policy>::depth_to(Price ticks) const noexcept {
+    const level_type* best = (S == Side::BUY) ? highest_buy_ : lowest_sell_;
+    std::uint64_t volume = 0;
+    if constexpr (!Policy::kDepthIndex) {
+        for (const level_type* level = best; level && !detail::worse_than<S>(level->price, ticks);
+             level = next_level<S>(level->price)) {
+            volume += level->total_volume;
+        }
+    } else {
+        if constexpr (!kSingleWindow) {
+            const auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+            for (auto it = detail::overflow_lower_bound<S>(overflow, ticks); it != overflow.end(); ++it) {
+                volume += (*it)->total_volume;
+            }
+        }
+        const Price first = (S == Side::BUY) ? std::max(ticks, window_lo_) : window_lo_;
+        const Price last = (S == Side::BUY) ? window_hi() : std::min(ticks, window_hi());
+        if (first <= last) {
+            volume += window_sum((S == Side::BUY) ? bid_depth_ : ask_depth_, first, last).volume;
+        }
+    }
+    return volume;
+}
+
+template <typename Policy>
+template<Side S>
+typename BasicOrderBook<Policy>::SweepQuote BasicOrderBook<Policy>::sweep(std::uint64_t quantity) const noexcept {
+    std::uint64_t remaining = quantity;
+    std::uint64_t notional = 0;     // in ticks, mod 2^64
+    Price last = 0;
+
+    auto take = [&](const level_type* level) {
+        const std::uint64_t qty = std::min<std::uint64_t>(remaining, level->total_volume);
+        if (qty != 0) {
+            remaining -= qty;
+            notional += qty * static_cast<std::uint64_t>(Price{level->price});
+            last = level->price;
+        }
+    };
+
+    if constexpr (!Policy::kDepthIndex) {
+        for (const level_type* level = (S == Side::BUY) ? highest_buy_ : lowest_sell_;
+             level && remaining != 0; level = next_level<S>(level->price)) {
+            take(level);
+        }
+    } else {
+        // Overflow levels better than the window, then the window through
+        // the tree, then overflow levels worse than it.
+        [[maybe_unused]] const auto& overflow = (S == Side::BUY) ? bid_overflow_ : ask_overflow_;
+        [[maybe_unused]] auto window_edge = overflow.begin();
+        if constexpr (!kSingleWindow) {
+            window_edge = detail::overflow_lower_bound<S>(overflow, (S == Side::BUY) ? window_lo_ : window_hi());
+            for (auto it = overflow.end(); it != window_edge && remaining != 0;) {
+                take(*--it);
+            }
+        }
+
+        const DepthIndex& depth = (S == Side::BUY) ? bid_depth_ : ask_depth_;
+        const Ladder& ladder = (S == Side::BUY) ? bid_ladder_ : ask_ladder_;
+        const DepthIndex::Sum total = depth.total();
+        if (remaining != 0 && total.volume != 0) {
+            if (total.volume <= remaining) {
+                remaining -= total.volume;
+                notional += total.notional;
+                // Worst non-empty level: lowest bid / highest ask.
+                last = ladder[logical_search(depth, (S == Side::BUY) ? 1 : total.volume)].price;
+            } else {
+                // Bids sweep down from the top of the window, asks up from the bottom.
+                const std::uint64_t target = (S == Side::BUY) ? total.volume - remaining + 1 : remaining;
+                const std::size_t slot = logical_search(depth, target);
+                const level_type* level = &ladder[slot];
+                const DepthIndex::Sum upto = logical_prefix(depth, slot);
+                std::uint64_t full_volume;
+                std::uint64_t full_notional;
+                if constexpr (S == Side::BUY) {
+                    full_volume = total.volume - upto.volume;
+                    full_notional = total.notional - upto.notional;
+                } else {
+                    full_volume = upto.volume - level->total_volume;
+                    full_notional = upto.notional - level->total_volume * static_cast<std::uint64_t>(Price{level->price});
+                }
+                notional += full_notional + (remaining - full_volume) * static_cast<std::uint64_t>(Price{level->price});
+                remaining = 0;
+                last = level->price;
+            }
+        }
+
+        if constexpr (!kSingleWindow) {
+            for (auto it = window_edge; it != overflow.begin() && remaining != 0;) {
+                take(*--it);
+            }
+        }
+    }
+
+    const std::uint64_t filled = quantity - remaining;
+    if (filled == 0) {
+        return SweepQuote{0, 0, 0};
+    }
+    const Price tick = scale().tick_size();
+    return SweepQuote{filled, to_price(last), static_cast<Price>(notional * static_cast<std::uint64_t>(tick))};
+}
+
+template <typename Policy>
+std::uint64_t BasicOrderBook<Policy>::get_bid_depth(price_type price) const noexcept {
+    // Bids at or above `price`: round an off-tick price up.
+    const Price tick = scale().tick_size();
+    const Price raw = price;
+    Price ticks = raw / tick;
+    if (raw % tick != 0 && raw > 0) {
+        ++ticks;
+    }
+    return depth_to<Side::BUY>(ticks);
+}
+
+template <typename Policy>
+std::uint64_t BasicOrderBook<Policy>::get_ask_depth(price_type price) const noexcept {
+    // Asks at or below `price`: round an off-tick price down.
+    const Price tick = scale().tick_size();
+    const Price raw = price;
+    Price ticks = raw / tick;
+    if (raw % tick != 0 && raw < 0) {
+        --ticks;
+    }
+    return depth_to<Side::SELL>(ticks);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::SweepQuote BasicOrderBook<Policy>::get_bid_sweep(std::uint64_t quantity) const noexcept {
+    return sweep<Side::BUY>(quantity);
+}
+
+template <typename Policy>
+typename BasicOrderBook<Policy>::SweepQuote BasicOrderBook<Policy>::get_ask_sweep(std::uint64_t quantity) const noexcept {
+    return sweep<Side::SELL>(quantity);
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::clear() {
+    // Walk the levels rather than the index so handle-only orders are released too.
+    auto release = [this](level_type& level) {
+        for (order_type* order = level.head_order; order;) {
+            order_type* next = order_store_.next(order);
+            order_store_.destroy(order);
+            order = next;
+        }
+    };
+    for (auto slot = bid_active_.find_next(0); slot; slot = bid_active_.find_next(*slot + 1)) {
+        release(bid_ladder_[*slot]);
+    }
+    for (auto slot = ask_active_.find_next(0); slot; slot = ask_active_.find_next(*slot + 1)) {
+        release(ask_ladder_[*slot]);
+    }
+    for (level_type* level : bid_overflow_) {
+        release(*level);
+        level_pool_->destroy(level);
+    }
+    for (level_type* level : ask_overflow_) {
+        release(*level);
+        level_pool_->destroy(level);
+    }
+    bid_overflow_.clear();
+    ask_overflow_.clear();
+    orders_.clear();
+    unindexed_orders_ = 0;
+    bid_active_.reset();
+    ask_active_.reset();
+
+    highest_buy_ = nullptr;
+    lowest_sell_ = nullptr;
+}
+
+template <typename Policy>
+std::size_t BasicOrderBook<Policy>::memory_usage() const noexcept {
+    return sizeof(*this)
+        + orders_.memory_usage()
+        + order_store_.memory_usage()
+        + own_level_pool_.memory_usage()
+        + bid_active_.memory_usage() + ask_active_.memory_usage()
+        + (bid_overflow_.capacity() + ask_overflow_.capacity()) * sizeof(level_type*)
+        + (bid_depth_.size() + ask_depth_.size()) * sizeof(DepthIndex::Sum);
+}
+
+template <typename Policy>
+void BasicOrderBook<Policy>::shrink_to_fit() {
+    orders_.shrink_to_fit();
+    if constexpr (Policy::kAllowGrowth) {
+        bid_overflow_.shrink_to_fit();
+        ask_overflow_.shrink_to_fit();
+    }
+}
+
+// Instantiated once in src/order_book.cpp.
+extern template class BasicOrderBook<DefaultBookPolicy>;
+
+}  // namespace lob
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef LOB_ORDER_INDEX_HPP
+#define LOB_ORDER_INDEX_HPP
+
+#include "compiler.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace lob {
+
+/**
+ * OrderIndex - flat open-addressing map from OrderId to a small value.
+ *
+ * Structure:
+ * - Single contiguous slot array (key + value inline, no per-entry nodes)
+ * - Robin Hood insertion keeps probe sequences short and sorted by distance
+ * - Backward-shift deletion: erase never leaves tombstones, so heavy cancel
+ *   flow does not degrade lookups over time
+ * - Identity hashing (key & mask): OrderIds are issued sequentially, so the
+ *   live set maps to mostly collision-free, adjacent slots and recent orders
+ *   share cache lines. OrderId 0 is reserved as the empty-slot marker.
+ *
+ * Growth mirrors ObjectPool: the table is pre-sized with reserve(), and when
+ * growth is disabled it never rehashes — full() reports when the configured
+ * load limit has been reached so callers can reject before inserting.
+ *
+ * Value must be cheap to copy; Value{} is returned for missing keys.
+ */
+template <typename Value>
+class OrderIndex {
+public:
+    OrderIndex() { rehash(kMinCapacity); }
+
+    OrderIndex(const OrderIndex&) = delete;
+    OrderIndex& operator=(const OrderIndex&) = delete;
+
+    // Size the table so `count` entries fit without exceeding the load limit.
+    void reserve(std::size_t count) {
+        std::size_t capacity = kMinCapacity;
+        while (max_size_for(capacity) < count) {
+            capacity <<= 1;
+        }
+        if (capacity > slots_.size()) {
+            rehash(capacity);
+        }
+    }
+
+    void set_allow_growth(bool allow_growth) noexcept {
+        allow_growth_ = allow_growth;
+    }
+
+    // Rehash down to the smallest table that holds the current entries.
+    void shrink_to_fit() {
+        std::size_t capacity = kMinCapacity;
+        while (max_size_for(capacity) < size_) {
+            capacity <<= 1;
+        }
+        if (capacity < slots_.size()) {
+            rehash(capacity);
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return slots_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+    [[nodiscard]] std::size_t memory_usage() const noexcept { return slots_.capacity() * sizeof(Slot); }
+
+    // True when another insert would exceed the load limit and growth is off.
+    [[nodiscard]] bool full() const noexcept {
+        return !allow_growth_ && size_ >= max_size_;
+    }
+
+    // Insert or overwrite. Returns false only when the table is full and
+    // growth is disabled.
+    bool insert(OrderId key, Value value) {
+        if (LOB_UNLIKELY(size_ >= max_size_)) {
+            if (!allow_growth_) {
+                return false;
+            }
+            rehash(slots_.size() << 1);
+        }
+
+        std::size_t pos = home(key);
+        std::size_t dist = 0;
+        while (true) {
+            Slot& slot = slots_[pos];
+            if (slot.key == kEmptyKey) {
+                slot.key = key;
+                slot.value = value;
+                ++size_;
+                return true;
+            }
+            if (slot.key == key) {
+                slot.value = value;
+                return true;
+            }
+            const std::size_t slot_dist = distance(slot.key, pos);
+            if (slot_dist < dist) {
+                std::swap(slot.key, key);
+                std::swap(slot.value, value);
+                dist = slot_dist;
+            }
+            pos = (pos + 1) & mask_;
+            ++dist;
+        }
+    }
+
+    [[nodiscard]] Value find(OrderId key) const noexcept {
+        const std::size_t pos = locate(key);
+        return pos == kNotFound ? Value{} : slots_[pos].value;
+    }
+
+    // Pull the key's home slot into cache ahead of a find/erase.
+    void prefetch(OrderId key) const noexcept {
+        LOB_PREFETCH(&slots_[home(key)]);
+    }
+
+    [[nodiscard]] bool contains(OrderId key) const noexcept {
+        return locate(key) != kNotFound;
+    }
+
+    bool erase(OrderId key) noexcept {
+        const std::size_t pos = locate(key);
+        if (pos == kNotFound) {
+            return false;
+        }
+        remove_at(pos);
+        return true;
+    }
+
+    // Lookup and erase in a single probe. Returns Value{} if absent.
+    [[nodiscard]] Value extract(OrderId key) noexcept {
+        const std::size_t pos = locate(key);
+        if (pos == kNotFound) {
+            return Value{};
+        }
+        Value value = slots_[pos].value;
+        remove_at(pos);
+        return value;
+    }
+
+    template <typename Fn>
+    void for_each(Fn&& fn) const {
+        for (const Slot& slot : slots_) {
+            if (slot.key != kEmptyKey) {
+                fn(slot.key, slot.value);
+            }
+        }
+    }
+
+    void clear() noexcept {
+        for (Slot& slot : slots_) {
+            slot.key = kEmptyKey;
+        }
+        size_ = 0;
+    }
+
+private:
+    struct Slot {
+        OrderId key;
+        Value value;
+    };
+
+    static constexpr OrderId kEmptyKey = 0;
+    static constexpr std::size_t kNotFound = ~std::size_t{0};
+    static constexpr std::size_t kMinCapacity = 16;
+
+    // Load limit of 3/4: Robin Hood probe lengths stay in the low single digits.
+    static constexpr std::size_t max_size_for(std::size_t capacity) noexcept {
+        return capacity - capacity / 4;
+    }
+
+    [[nodiscard]] std::size_t home(OrderId key) const noexcept {
+        return static_cast<std::size_t>(key) & mask_;
+    }
+
+    [[nodiscard]] std::size_t distance(OrderId key, std::size_t pos) const noexcept {
+        return (pos - home(key)) & mask_;
+    }
+
+    [[nodiscard]] std::size_t locate(OrderId key) const noexcept {
+        std::size_t pos = home(key);
+        std::size_t dist = 0;
+        while (true) {
+            const Slot& slot = slots_[pos];
+            if (slot.key == key) {
+                return key == kEmptyKey ? kNotFound : pos;
+            }
+            if (slot.key == kEmptyKey || distance(slot.key, pos) < dist) {
+                return kNotFound;
+            }
+            pos = (pos + 1) & mask_;
+            ++dist;
+        }
+    }
+
+    void remove_at(std::size_t pos) noexcept {
+        std::size_t next = (pos + 1) & mask_;
+        while (slots_[next].key != kEmptyKey && distance(slots_[next].key, next) != 0) {
+            slots_[pos] = slots_[next];
+            pos = next;
+            next = (next + 1) & mask_;
+        }
+        slots_[pos].key = kEmptyKey;
+        --size_;
+    }
+
+    void rehash(std::size_t capacity) {
+        std::vector<Slot> old;
+        old.swap(slots_);
+        slots_.assign(capacity, Slot{kEmptyKey, Value{}});
+        mask_ = capacity - 1;
+        max_size_ = max_size_for(capacity);
+        size_ = 0;
+
+        for (const Slot& slot : old) {
+            if (slot.key != kEmptyKey) {
+                insert(slot.key, slot.value);
+            }
+        }
+    }
+
+    std::vector<Slot> slots_;
+    std::size_t mask_ = 0;
+    std::size_t size_ = 0;
+    std::size_t max_size_ = 0;
+    bool allow_growth_ = true;
+};
+
+}  // namespace lob
+
+#endif
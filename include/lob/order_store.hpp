@@ -0,0 +1,287 @@
+#ifndef LOB_ORDER_STORE_HPP
+#define LOB_ORDER_STORE_HPP
+
+#include "compiler.hpp"
+#include "object_pool.hpp"
+#include "order.hpp"
+#include "types.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace lob {
+
+/**
+ * Order stores - where BasicOrderBook keeps resting orders.
+ *
+ * Both stores hand out stable `order_type*` records carrying the fields the
+ * matching loop reads on every step (price in ticks, remaining_quantity,
+ * side, is_filled/fill). Queue links, the order id, original quantity,
+ * entry time and handle data go through the store, so the book and
+ * BasicPriceLevel are written once against this interface:
+ *
+ *   create / destroy / transient / resolve / handle_of / live
+ *   next / prev / set_next / set_prev
+ *   id / quantity / set_quantity / indexed / restamp
+ *
+ * PooledOrderStore keeps whole BasicOrder objects in an ObjectPool with
+ * pointer links; the pool may be an arena shared by many books (see
+ * BookRegistry). CompactOrderStore splits each order into a hot record
+ * (32-bit links, remaining quantity, price, side) and a cold record (id,
+ * original quantity, entry time, generation) in parallel index-addressed
+ * arrays. Neither stores the order's level: the book finds it from the
+ * price.
+ */
+
+// Whole-object store: the original layout.
+template <typename PriceT, typename QuantityT>
+class PooledOrderStore {
+public:
+    using order_type = BasicOrder<PriceT, QuantityT>;
+    using pool_type = ObjectPool<order_type>;
+
+    PooledOrderStore() noexcept : pool_(&own_pool_) {}
+    PooledOrderStore(const PooledOrderStore&) = delete;
+    PooledOrderStore& operator=(const PooledOrderStore&) = delete;
+
+    // Take orders from `arena`, shared with other stores, instead of an own
+    // pool. Call before the first create.
+    void use_arena(pool_type& arena) noexcept { pool_ = &arena; }
+
+    void reserve(std::size_t count) { pool_->reserve(count); }
+    void set_allow_growth(bool allow_growth) noexcept { pool_->set_allow_growth(allow_growth); }
+    void set_page_options(PageOptions options) noexcept { pool_->set_page_options(options); }
+    [[nodiscard]] std::size_t capacity() const noexcept { return pool_->capacity(); }
+    // Own pool only, like memory_usage(); an arena is prefaulted by its owner.
+    void prefault() noexcept { own_pool_.prefault(); }
+    // Own pool only; an arena is accounted by its owner.
+    [[nodiscard]] std::size_t memory_usage() const noexcept { return own_pool_.memory_usage(); }
+
+    order_type* create(OrderId id, PriceT price, QuantityT quantity, Side side, bool indexed) {
+        return pool_->create(id, price, quantity, side, indexed);
+    }
+    void destroy(order_type* order) noexcept { pool_->destroy(order); }
+
+    // Order that only lives for one matching call (never rests).
+    [[nodiscard]] static order_type transient(OrderId id, PriceT price, QuantityT quantity, Side side) noexcept {
+        return order_type(id, price, quantity, side, false);
+    }
+
+    [[nodiscard]] order_type* resolve(OrderHandle handle) const noexcept {
+        return pool_->resolve(handle.slot, handle.generation);
+    }
+    [[nodiscard]] OrderHandle handle_of(const order_type* order) const noexcept {
+        return OrderHandle{ObjectPool<order_type>::slot_of(order), ObjectPool<order_type>::generation_of(order)};
+    }
+    // Whether the slot still holds a created order (odd generation).
+    [[nodiscard]] static bool live(const order_type* order) noexcept {
+        return (ObjectPool<order_type>::generation_of(order) & 1u) != 0;
+    }
+
+    [[nodiscard]] order_type* next(const order_type* order) const noexcept { return order->next_order; }
+    [[nodiscard]] order_type* prev(const order_type* order) const noexcept { return order->prev_order; }
+    void set_next(order_type* order, order_type* next) noexcept { order->next_order = next; }
+    void set_prev(order_type* order, order_type* prev) noexcept { order->prev_order = prev; }
+
+    [[nodiscard]] OrderId id(const order_type* order) const noexcept { return order->id; }
+    [[nodiscard]] QuantityT quantity(const order_type* order) const noexcept { return order->quantity; }
+    void set_quantity(order_type* order, QuantityT quantity) noexcept { order->quantity = quantity; }
+    [[nodiscard]] bool indexed(const order_type* order) const noexcept { return order->indexed; }
+    void restamp(order_type* order) noexcept { order->entry_time = order_type::now_timestamp(); }
+
+private:
+    pool_type own_pool_;
+    pool_type* pool_;
+};
+
+// Hot half of a compact order: everything queue traversal, matching and
+// cancel touch. 32 bytes with 64-bit prices and quantities.
+template <typename PriceT, typename QuantityT>
+struct BasicCompactOrder {
+    using price_type = PriceT;
+    using quantity_type = QuantityT;
+
+    static constexpr std::uint32_t kNone = ~std::uint32_t{0};
+
+    PriceT price;
+    QuantityT remaining_quantity;
+    std::uint32_t slot;     // own index; kNone for transient orders
+    std::uint32_t prev;
+    std::uint32_t next;     // free-list link while the slot is unused
+    Side side;
+
+    [[nodiscard]] bool is_filled() const noexcept {
+        return remaining_quantity == 0;
+    }
+
+    void fill(QuantityT qty) noexcept {
+        remaining_quantity = (qty >= remaining_quantity) ? 0 : remaining_quantity - qty;
+    }
+};
+
+static_assert(sizeof(BasicCompactOrder<Price, Quantity>) <= 32, "compact hot record exceeds 32 bytes");
+
+// Split store: hot and cold records in parallel blocks addressed by a
+// 32-bit slot. Blocks never move, so record pointers stay valid as the
+// store grows. Generations follow ObjectPool: odd while the slot is live,
+// and, as there, never-used slots come from a bump pointer while the free
+// list holds only recycled ones.
+template <typename PriceT, typename QuantityT, std::size_t BlockSize = 4096>
+class CompactOrderStore {
+    static_assert((BlockSize & (BlockSize - 1)) == 0, "BlockSize must be a power of two");
+
+public:
+    using order_type = BasicCompactOrder<PriceT, QuantityT>;
+
+    CompactOrderStore() = default;
+    CompactOrderStore(const CompactOrderStore&) = delete;
+    CompactOrderStore& operator=(const CompactOrderStore&) = delete;
+
+    void reserve(std::size_t count) {
+        const std::size_t needed_blocks = (count + BlockSize - 1) / BlockSize;
+        if (hot_blocks_.size() < needed_blocks) {
+            allocate_blocks(needed_blocks - hot_blocks_.size());
+        }
+    }
+    void set_allow_growth(bool allow_growth) noexcept { allow_growth_ = allow_growth; }
+    // Backing for blocks allocated from now on (see ObjectPool).
+    void set_page_options(PageOptions options) noexcept { page_options_ = options; }
+    [[nodiscard]] std::size_t capacity() const noexcept { return hot_blocks_.size() * BlockSize; }
+    [[nodiscard]] std::size_t high_water() const noexcept { return high_water_; }
+    // Fault in the reserved pages now (see ObjectPool).
+    void prefault() noexcept {
+        for (PageRegion& region : regions_) {
+            region.prefault();
+        }
+    }
+    [[nodiscard]] std::size_t memory_usage() const noexcept { return capacity() * (sizeof(order_type) + sizeof(Cold)); }
+
+    order_type* create(OrderId id, PriceT price, QuantityT quantity, Side side, bool indexed) {
+        std::uint32_t slot = free_head_;
+        order_type* order;
+        if (LOB_LIKELY(slot != order_type::kNone)) {
+            order = hot(slot);
+            free_head_ = order->next;
+        } else {
+            if (LOB_UNLIKELY(high_water_ == capacity())) {
+                if (LOB_UNLIKELY(!allow_growth_)) {
+                    return nullptr;
+                }
+                allocate_blocks(1);
+            }
+            slot = static_cast<std::uint32_t>(high_water_++);
+            order = hot(slot);
+            order->slot = slot;
+            cold(slot).generation = 0;
+        }
+
+        order->prev = order_type::kNone;
+        order->next = order_type::kNone;
+        order->price = price;
+        order->remaining_quantity = quantity;
+        order->side = side;
+
+        Cold& record = cold(slot);
+        record.id = id;
+        record.quantity = quantity;
+        record.entry_time = BasicOrder<PriceT, QuantityT>::now_timestamp();
+        ++record.generation;
+        record.indexed = indexed;
+        return order;
+    }
+
+    void destroy(order_type* order) noexcept {
+        if (!order) {
+            return;
+        }
+        ++cold(order->slot).generation;
+        order->next = free_head_;
+        free_head_ = order->slot;
+    }
+
+    [[nodiscard]] static order_type transient(OrderId, PriceT price, QuantityT quantity, Side side) noexcept {
+        return order_type{price, quantity, order_type::kNone, order_type::kNone, order_type::kNone, side};
+    }
+
+    [[nodiscard]] order_type* resolve(OrderHandle handle) const noexcept {
+        if (LOB_UNLIKELY(handle.slot >= high_water_)) {
+            return nullptr;
+        }
+        const std::uint32_t generation = cold(handle.slot).generation;
+        if (LOB_UNLIKELY(generation != handle.generation || (generation & 1u) == 0)) {
+            return nullptr;
+        }
+        return hot(handle.slot);
+    }
+    [[nodiscard]] OrderHandle handle_of(const order_type* order) const noexcept {
+        return OrderHandle{order->slot, cold(order->slot).generation};
+    }
+    [[nodiscard]] bool live(const order_type* order) const noexcept {
+        return (cold(order->slot).generation & 1u) != 0;
+    }
+
+    [[nodiscard]] order_type* next(const order_type* order) const noexcept { return at(order->next); }
+    [[nodiscard]] order_type* prev(const order_type* order) const noexcept { return at(order->prev); }
+    void set_next(order_type* order, const order_type* next) noexcept { order->next = index_of(next); }
+    void set_prev(order_type* order, const order_type* prev) noexcept { order->prev = index_of(prev); }
+
+    [[nodiscard]] OrderId id(const order_type* order) const noexcept { return cold(order->slot).id; }
+    [[nodiscard]] QuantityT quantity(const order_type* order) const noexcept { return cold(order->slot).quantity; }
+    void set_quantity(order_type* order, QuantityT quantity) noexcept { cold(order->slot).quantity = quantity; }
+    [[nodiscard]] bool indexed(const order_type* order) const noexcept { return cold(order->slot).indexed; }
+    void restamp(order_type* order) noexcept {
+        cold(order->slot).entry_time = BasicOrder<PriceT, QuantityT>::now_timestamp();
+    }
+
+private:
+    struct Cold {
+        OrderId id;
+        QuantityT quantity;
+        Timestamp entry_time;
+        std::uint32_t generation;
+        bool indexed;
+    };
+
+    static constexpr std::size_t kBlockShift = __builtin_ctzll(BlockSize);
+
+    [[nodiscard]] order_type* hot(std::uint32_t slot) const noexcept {
+        return hot_blocks_[slot >> kBlockShift] + (slot & (BlockSize - 1));
+    }
+    [[nodiscard]] Cold& cold(std::uint32_t slot) const noexcept {
+        return cold_blocks_[slot >> kBlockShift][slot & (BlockSize - 1)];
+    }
+    [[nodiscard]] order_type* at(std::uint32_t slot) const noexcept {
+        return slot == order_type::kNone ? nullptr : hot(slot);
+    }
+    [[nodiscard]] static std::uint32_t index_of(const order_type* order) noexcept {
+        return order ? order->slot : order_type::kNone;
+    }
+
+    // Hot and cold halves of `count` blocks, one region each. Records are
+    // written when their slot is first handed out.
+    void allocate_blocks(std::size_t count) {
+        auto* hot_nodes = static_cast<order_type*>(
+            regions_.emplace_back(count * BlockSize * sizeof(order_type), page_options_).data());
+        auto* cold_nodes = static_cast<Cold*>(
+            regions_.emplace_back(count * BlockSize * sizeof(Cold), page_options_).data());
+        std::uninitialized_default_construct_n(hot_nodes, count * BlockSize);
+        std::uninitialized_default_construct_n(cold_nodes, count * BlockSize);
+        for (std::size_t b = 0; b < count; ++b) {
+            hot_blocks_.push_back(hot_nodes + b * BlockSize);
+            cold_blocks_.push_back(cold_nodes + b * BlockSize);
+        }
+    }
+
+    std::vector<order_type*> hot_blocks_;
+    std::vector<Cold*> cold_blocks_;
+    std::vector<PageRegion> regions_;
+    std::uint32_t free_head_ = order_type::kNone;  // recycled slots only
+    std::size_t high_water_ = 0;
+    PageOptions page_options_{};
+    bool allow_growth_ = true;
+};
+
+}  // namespace lob
+
+#endif
@@ -0,0 +1,333 @@
+#ifndef LOB_PAGE_ALLOCATOR_HPP
+#define LOB_PAGE_ALLOCATOR_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <string>
+#include <utility>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define LOB_HAVE_MMAP 1
+#endif
+
+namespace lob {
+
+/**
+ * Page allocator - page-aligned regions under ObjectPool blocks and books.
+ *
+ * PageOptions pick how a region is backed:
+ * - huge: a region of at least one huge page tries explicit huge pages
+ *   (MAP_HUGETLB) first, then a huge-page-aligned mapping advised for
+ *   transparent huge pages (MADV_HUGEPAGE). Smaller regions, and systems
+ *   with neither, fall back to ordinary pages
+ * - lock: mlock the region so it is never paged out. A failure (e.g. over
+ *   RLIMIT_MEMLOCK) is counted, not fatal
+ * - prefault: touch every page at allocation instead of on first use
+ *
+ * Default options keep the plain operator new path. page_stats() counts
+ * how the live regions ended up backed; transparent huge pages are only
+ * advised, so anon_huge_page_bytes() reports what the kernel actually
+ * gave the process.
+ */
+struct PageOptions {
+    bool huge = false;
+    bool lock = false;
+    bool prefault = false;
+
+    [[nodiscard]] constexpr bool plain() const noexcept { return !huge && !lock && !prefault; }
+};
+
+enum class PageBacking : std::uint8_t {
+    Heap,           // operator new (plain options, or no mmap)
+    Small,          // ordinary pages
+    Transparent,    // advised for transparent huge pages
+    Explicit,       // MAP_HUGETLB
+};
+
+// Live bytes by backing, plus cumulative fallbacks and failures.
+struct PageStats {
+    std::uint64_t heap_bytes;
+    std::uint64_t small_bytes;
+    std::uint64_t transparent_bytes;
+    std::uint64_t explicit_bytes;
+    std::uint64_t locked_bytes;
+    std::uint64_t huge_fallbacks;   // huge requested, ordinary pages used
+    std::uint64_t lock_failures;
+
+    // Share of page-allocated bytes backed (or advised) by huge pages.
+    [[nodiscard]] double huge_coverage() const noexcept {
+        const std::uint64_t huge = transparent_bytes + explicit_bytes;
+        const std::uint64_t total = huge + small_bytes;
+        return total == 0 ? 0.0 : static_cast<double>(huge) / static_cast<double>(total);
+    }
+};
+
+static constexpr std::size_t kHugePageSize = std::size_t{2} << 20;
+
+namespace detail {
+
+struct PageCounters {
+    std::atomic<std::uint64_t> bytes[4]{};
+    std::atomic<std::uint64_t> locked_bytes{0};
+    std::atomic<std::uint64_t> huge_fallbacks{0};
+    std::atomic<std::uint64_t> lock_failures{0};
+};
+
+inline PageCounters& page_counters() noexcept {
+    static PageCounters counters;
+    return counters;
+}
+
+// Room below an object placed by page_new() for its region record.
+static constexpr std::size_t kPageHeader = 64;
+
+constexpr std::size_t round_up(std::size_t bytes, std::size_t unit) noexcept {
+    return (bytes + unit - 1) / unit * unit;
+}
+
+}  // namespace detail
+
+inline PageStats page_stats() noexcept {
+    const detail::PageCounters& c = detail::page_counters();
+    return PageStats{
+        c.bytes[static_cast<int>(PageBacking::Heap)].load(std::memory_order_relaxed),
+        c.bytes[static_cast<int>(PageBacking::Small)].load(std::memory_order_relaxed),
+        c.bytes[static_cast<int>(PageBacking::Transparent)].load(std::memory_order_relaxed),
+        c.bytes[static_cast<int>(PageBacking::Explicit)].load(std::memory_order_relaxed),
+        c.locked_bytes.load(std::memory_order_relaxed),
+        c.huge_fallbacks.load(std::memory_order_relaxed),
+        c.lock_failures.load(std::memory_order_relaxed),
+    };
+}
+
+// AnonHugePages of the whole process from /proc/self/smaps_rollup; 0 where
+// unavailable.
+inline std::uint64_t anon_huge_page_bytes() {
+    std::ifstream in("/proc/self/smaps_rollup");
+    std::string key;
+    while (in >> key) {
+        std::uint64_t kilobytes = 0;
+        if (key == "AnonHugePages:" && in >> kilobytes) {
+            return kilobytes * 1024;
+        }
+        in.ignore(256, '\n');
+    }
+    return 0;
+}
+
+// One owned region. Allocation failure throws std::bad_alloc, as new does.
+class PageRegion {
+public:
+    PageRegion() noexcept = default;
+
+    PageRegion(std::size_t bytes, PageOptions options) {
+        if (bytes == 0) {
+            return;
+        }
+#if defined(LOB_HAVE_MMAP)
+        if (!options.plain()) {
+            map(bytes, options);
+            account(+1);
+            return;
+        }
+#endif
+        (void)options;
+        data_ = ::operator new(bytes);
+        size_ = bytes;
+        backing_ = PageBacking::Heap;
+        account(+1);
+    }
+
+    ~PageRegion() { release(); }
+
+    PageRegion(PageRegion&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , backing_(other.backing_)
+        , locked_(std::exchange(other.locked_, false)) {}
+
+    PageRegion& operator=(PageRegion&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            backing_ = other.backing_;
+            locked_ = std::exchange(other.locked_, false);
+        }
+        return *this;
+    }
+
+    PageRegion(const PageRegion&) = delete;
+    PageRegion& operator=(const PageRegion&) = delete;
+
+    [[nodiscard]] void* data() const noexcept { return data_; }
+    // Usable bytes; at least the requested size, rounded up to whole pages.
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] PageBacking backing() const noexcept { return backing_; }
+    [[nodiscard]] bool locked() const noexcept { return locked_; }
+
+    // Touch every page now, keeping its contents, so later first uses take
+    // no page faults.
+    void prefault() noexcept {
+        auto* bytes = static_cast<volatile unsigned char*>(data_);
+        // Per small page even under THP: the kernel may still fall back.
+        const std::size_t step = backing_ == PageBacking::Explicit ? kHugePageSize : page_size();
+        for (std::size_t offset = 0; offset < size_; offset += step) {
+            bytes[offset] = bytes[offset];
+        }
+    }
+
+    // Usable bytes a region of `bytes` gets under `options`.
+    [[nodiscard]] static std::size_t rounded_size(std::size_t bytes, PageOptions options) noexcept {
+#if defined(LOB_HAVE_MMAP)
+        if (!options.plain()) {
+            return detail::round_up(bytes, options.huge && bytes >= kHugePageSize ? kHugePageSize : page_size());
+        }
+#endif
+        (void)options;
+        return bytes;
+    }
+
+    [[nodiscard]] static std::size_t page_size() noexcept {
+#if defined(LOB_HAVE_MMAP)
+        static const std::size_t size = [] {
+            const long page = sysconf(_SC_PAGESIZE);
+            return page > 0 ? static_cast<std::size_t>(page) : std::size_t{4096};
+        }();
+        return size;
+#else
+        return 4096;
+#endif
+    }
+
+private:
+#if defined(LOB_HAVE_MMAP)
+    void map(std::size_t bytes, PageOptions options) {
+        constexpr int kFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+        size_ = rounded_size(bytes, options);
+        backing_ = PageBacking::Small;
+        const bool huge = options.huge && bytes >= kHugePageSize;
+        if (huge) {
+#if defined(MAP_HUGETLB)
+            void* mapped = mmap(nullptr, size_, PROT_READ | PROT_WRITE, kFlags | MAP_HUGETLB, -1, 0);
+            if (mapped != MAP_FAILED) {
+                data_ = mapped;
+                backing_ = PageBacking::Explicit;
+            }
+#endif
+            if (!data_) {
+                map_aligned();
+            }
+        } else {
+            void* mapped = mmap(nullptr, size_, PROT_READ | PROT_WRITE, kFlags, -1, 0);
+            if (mapped == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            data_ = mapped;
+        }
+        if (options.huge && backing_ == PageBacking::Small) {
+            detail::page_counters().huge_fallbacks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        if (options.lock) {
+            locked_ = mlock(data_, size_) == 0;
+            if (!locked_) {
+                detail::page_counters().lock_failures.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (options.prefault) {
+            prefault();
+        }
+    }
+
+    // Huge-page-aligned mapping (over-map, trim both ends) so THP can back
+    // it with whole huge pages.
+    void map_aligned() {
+        constexpr int kFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+        void* mapped = mmap(nullptr, size_ + kHugePageSize, PROT_READ | PROT_WRITE, kFlags, -1, 0);
+        if (mapped == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        const auto base = reinterpret_cast<std::uintptr_t>(mapped);
+        const std::uintptr_t aligned = detail::round_up(base, kHugePageSize);
+        if (aligned != base) {
+            munmap(mapped, aligned - base);
+        }
+        const std::size_t tail = kHugePageSize - (aligned - base);
+        if (tail != 0) {
+            munmap(reinterpret_cast<void*>(aligned + size_), tail);
+        }
+        data_ = reinterpret_cast<void*>(aligned);
+#if defined(MADV_HUGEPAGE)
+        if (madvise(data_, size_, MADV_HUGEPAGE) == 0) {
+            backing_ = PageBacking::Transparent;
+        }
+#endif
+    }
+#endif
+
+    void account(int sign) noexcept {
+        detail::PageCounters& c = detail::page_counters();
+        const auto bytes = static_cast<std::uint64_t>(size_);
+        if (sign > 0) {
+            c.bytes[static_cast<int>(backing_)].fetch_add(bytes, std::memory_order_relaxed);
+            if (locked_) {
+                c.locked_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            }
+        } else {
+            c.bytes[static_cast<int>(backing_)].fetch_sub(bytes, std::memory_order_relaxed);
+            if (locked_) {
+                c.locked_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void release() noexcept {
+        if (!data_) {
+            return;
+        }
+        account(-1);
+#if defined(LOB_HAVE_MMAP)
+        if (backing_ != PageBacking::Heap) {
+            munmap(data_, size_);
+            data_ = nullptr;
+            return;
+        }
+#endif
+        ::operator delete(data_);
+        data_ = nullptr;
+    }
+
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+    PageBacking backing_ = PageBacking::Heap;
+    bool locked_ = false;
+};
+
+// operator new / delete for a class placed in its own region: the region
+// record sits in a header just below the object.
+inline void* page_new(std::size_t bytes, PageOptions options) {
+    static_assert(sizeof(PageRegion) <= detail::kPageHeader, "region header too small");
+    PageRegion region(bytes + detail::kPageHeader, options);
+    void* data = region.data();
+    ::new (data) PageRegion(std::move(region));
+    return static_cast<unsigned char*>(data) + detail::kPageHeader;
+}
+
+inline void page_delete(void* object) noexcept {
+    if (!object) {
+        return;
+    }
+    auto* header = reinterpret_cast<PageRegion*>(static_cast<unsigned char*>(object) - detail::kPageHeader);
+    PageRegion region(std::move(*header));
+    header->~PageRegion();
+}
+
+}  // namespace lob
+
+#endif
@@ -12,7 +12,11 @@ namespace lob {
  * Structure:
  * - Compact aggregate fields (price/volume/count)
  * - Doubly linked list of orders (headOrder/tailOrder) for O(1) order operations
- * - Indexed by tick ladder in OrderBook for cache-friendly lookup
+ * - Stored inline in OrderBook's tick ladder (pool-allocated only for
+ *   overflow levels), so the level for a price is found by address
+ * - Queue links are read and written through the book's order store
+ *   (order_store.hpp), so the same level works over pointer-linked and
+ *   index-linked orders
  * 
  * Performance:
  * - Add order to existing level: O(1)
@@ -21,18 +25,23 @@ namespace lob {
  * - Execute order: O(1)
  * - GetVolumeAtLimit: O(1)
  */
-class PriceLevel {
+template <typename PriceT, typename QuantityT, typename OrderT = BasicOrder<PriceT, QuantityT>>
+class BasicPriceLevel {
 public:
+    using order_type = OrderT;
+
     // Price and aggregate data
-    Price price;
-    Quantity total_volume;      // Total quantity at this price level
+    PriceT price;
+    QuantityT total_volume;     // Total quantity at this price level
     size_t order_count_;        // Number of orders at this level
 
     // Doubly linked list of orders at this price
-    Order* head_order;
-    Order* tail_order;
+    order_type* head_order;
+    order_type* tail_order;
+
+    BasicPriceLevel() noexcept : BasicPriceLevel(PriceT{0}) {}
 
-    explicit PriceLevel(Price price_) noexcept
+    explicit BasicPriceLevel(PriceT price_) noexcept
         : price(price_)
         , total_volume(0)
         , order_count_(0)
@@ -41,13 +50,13 @@ public:
     {}
 
     // Add order to tail of the order list - O(1)
-    void add_order(Order* order) noexcept {
-        order->parent_level = this;
-        order->prev_order = tail_order;
-        order->next_order = nullptr;
+    template <typename Store>
+    void add_order(order_type* order, Store& store) noexcept {
+        store.set_prev(order, tail_order);
+        store.set_next(order, nullptr);
         
         if (tail_order) {
-            tail_order->next_order = order;
+            store.set_next(tail_order, order);
         } else {
             head_order = order;
         }
@@ -58,48 +67,49 @@ public:
     }
 
     // Remove order from list - O(1)
-    void remove_order(Order* order) noexcept {
-        if (order->prev_order) {
-            order->prev_order->next_order = order->next_order;
+    template <typename Store>
+    void remove_order(order_type* order, Store& store) noexcept {
+        order_type* prev = store.prev(order);
+        order_type* next = store.next(order);
+        if (prev) {
+            store.set_next(prev, next);
         } else {
-            head_order = order->next_order;
+            head_order = next;
         }
         
-        if (order->next_order) {
-            order->next_order->prev_order = order->prev_order;
+        if (next) {
+            store.set_prev(next, prev);
         } else {
-            tail_order = order->prev_order;
+            tail_order = prev;
         }
         
         total_volume -= order->remaining_quantity;
         --order_count_;
         
-        order->prev_order = nullptr;
-        order->next_order = nullptr;
-        order->parent_level = nullptr;
+        store.set_prev(order, nullptr);
+        store.set_next(order, nullptr);
     }
 
-    [[nodiscard]] Order* front() const noexcept {
+    [[nodiscard]] order_type* front() const noexcept {
         return head_order;
     }
 
     // Pop front order - O(1) for execute operations
-    void pop_front() noexcept {
+    template <typename Store>
+    void pop_front(Store& store) noexcept {
         if (head_order) {
-            Order* old_head = head_order;
+            order_type* old_head = head_order;
             total_volume -= old_head->remaining_quantity;
             --order_count_;
             
-            head_order = old_head->next_order;
+            head_order = store.next(old_head);
             if (head_order) {
-                head_order->prev_order = nullptr;
+                store.set_prev(head_order, nullptr);
             } else {
                 tail_order = nullptr;
             }
             
-            old_head->prev_order = nullptr;
-            old_head->next_order = nullptr;
-            old_head->parent_level = nullptr;
+            store.set_next(old_head, nullptr);
         }
     }
 
@@ -113,11 +123,13 @@ public:
 
     void update_quantity(int64_t delta) noexcept {
         int64_t new_qty = static_cast<int64_t>(total_volume) + delta;
-        total_volume = (new_qty < 0) ? 0 : static_cast<Quantity>(new_qty);
+        total_volume = (new_qty < 0) ? 0 : static_cast<QuantityT>(new_qty);
     }
 
 };
 
+using PriceLevel = BasicPriceLevel<Price, Quantity>;
+
 }
 
 #endif
@@ -100,6 +100,12 @@ inline uint64_t read_be64(const char* p) noexcept {
 
 } // namespace detail
 
+// ITCH prices are dollars * kPriceScale. Books fed straight from parse()
+// should use kPennyTick (US equities at or above $1) as their tick size so
+// ladders are indexed in cents rather than 1/10000 dollars.
+inline constexpr int64_t kPriceScale = 10000;
+inline constexpr int64_t kPennyTick = kPriceScale / 100;
+
 // ITCH 5.0 message sizes (bytes)
 // Add Order (A):        36 bytes
 // Add Order MPID (F):   40 bytes
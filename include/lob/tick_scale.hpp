@@ -0,0 +1,83 @@
+#ifndef LOB_TICK_SCALE_HPP
+#define LOB_TICK_SCALE_HPP
+
+#include "compiler.hpp"
+#include "types.hpp"
+#include <cstdint>
+
+namespace lob {
+
+/**
+ * TickScale - exact conversion between raw prices and tick numbers.
+ *
+ * The tick is split into 2^shift * odd. A raw price is on-tick iff its low
+ * `shift` bits are zero and the remaining value is a multiple of `odd`,
+ * which is tested with the odd part's multiplicative inverse mod 2^64: the
+ * product is the exact quotient for multiples and lands outside
+ * [-bound, bound] otherwise. No divide instruction on the hot path.
+ *
+ * Performance:
+ * - to_ticks: and + shift + multiply + compare
+ * - to_price: multiply
+ */
+class TickScale {
+public:
+    // Ticks <= 0 are treated as 1.
+    constexpr explicit TickScale(Price tick_size = 1) noexcept
+        : tick_size_(tick_size > 0 ? tick_size : 1)
+        , low_mask_(0)
+        , shift_(0)
+        , inverse_(1)
+        , bound_(0)
+        , limit_(0) {
+        std::uint64_t odd = static_cast<std::uint64_t>(tick_size_);
+        while ((odd & 1u) == 0) {
+            odd >>= 1;
+            ++shift_;
+        }
+        low_mask_ = (std::uint64_t{1} << shift_) - 1;
+
+        // Newton iteration doubles the correct low bits each step: 5 -> 64.
+        std::uint64_t inverse = odd;
+        for (int i = 0; i < 5; ++i) {
+            inverse *= 2 - odd * inverse;
+        }
+        inverse_ = inverse;
+
+        // Quotients of on-tick prices lie in [-bound_, bound_].
+        bound_ = static_cast<std::uint64_t>(INT64_MAX) / odd;
+        limit_ = 2 * bound_;
+    }
+
+    [[nodiscard]] constexpr Price tick_size() const noexcept { return tick_size_; }
+
+    // Tick number for an on-tick price; false for off-tick prices (and for
+    // INT64_MIN, whose quotient has no positive counterpart).
+    [[nodiscard]] constexpr bool to_ticks(Price price, Price& ticks) const noexcept {
+        if (LOB_UNLIKELY((static_cast<std::uint64_t>(price) & low_mask_) != 0)) {
+            return false;
+        }
+        const std::uint64_t quotient = static_cast<std::uint64_t>(price >> shift_) * inverse_;
+        if (LOB_UNLIKELY(quotient + bound_ > limit_)) {
+            return false;
+        }
+        ticks = static_cast<Price>(quotient);
+        return true;
+    }
+
+    [[nodiscard]] constexpr Price to_price(Price ticks) const noexcept {
+        return ticks * tick_size_;
+    }
+
+private:
+    Price tick_size_;
+    std::uint64_t low_mask_;
+    unsigned shift_;
+    std::uint64_t inverse_;
+    std::uint64_t bound_;
+    std::uint64_t limit_;
+};
+
+}  // namespace lob
+
+#endif
@@ -7,18 +7,60 @@ namespace lob {
 
 enum class Side : uint8_t { BUY, SELL };
 
+// Time-in-force / execution instructions, selected at compile time on the
+// add path so plain limit orders carry no extra checks.
+enum class OrderType : uint8_t {
+    LIMIT,              // Match, rest the residual
+    MARKET,             // Match at any price, cancel the residual
+    IOC,                // Match up to the limit, cancel the residual
+    FOK,                // Fill completely up to the limit or do nothing
+    POST_ONLY,          // Rest without matching; rejected if it would cross
+    POST_ONLY_SLIDE,    // Rest without matching; re-priced one tick behind the opposite best if it would cross
+};
+
 using OrderId = uint64_t;
 using Quantity = uint64_t;
 using Timestamp = uint64_t;
 using Price = int64_t;
+using SymbolId = uint32_t;
 
-struct Fill {
+// Compact reference to a resting order: object pool slot plus generation.
+// A handle goes stale once the order is filled or cancelled; the book
+// rejects stale handles with an O(1) bounds + generation check.
+struct OrderHandle {
+    std::uint32_t slot;
+    std::uint32_t generation;
+};
+
+template <typename PriceT, typename QuantityT>
+struct BasicFill {
     OrderId buy_order_id;
     OrderId sell_order_id;
-    Price price;
-    Quantity quantity;
+    PriceT price;
+    QuantityT quantity;
 };
 
+using Fill = BasicFill<Price, Quantity>;
+
+enum class BookAction : uint8_t { ADD, CANCEL, MODIFY, REPLACE };
+
+// One entry of a command batch for BasicOrderBook::apply_batch.
+// - ADD: price, quantity, side, type (order_id ignored)
+// - CANCEL: order_id
+// - MODIFY: order_id, quantity (new total, as in modify_order)
+// - REPLACE: order_id, price, quantity (as in replace_order)
+template <typename PriceT, typename QuantityT>
+struct BasicBookCommand {
+    BookAction action;
+    Side side;
+    OrderType type;
+    OrderId order_id;
+    PriceT price;
+    QuantityT quantity;
+};
+
+using BookCommand = BasicBookCommand<Price, Quantity>;
+
 }
 
 #endif
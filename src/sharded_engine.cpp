@@ -3,189 +3,900 @@
 
 #include <algorithm>
 #include <cstddef>
-#include <functional>
 #include <thread>
 
 namespace lob::engine {
 
-namespace {
-
-std::uint64_t current_thread_token() {
-    return static_cast<std::uint64_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
-}
-
-}  // namespace
-
-ShardedEngine::ShardedEngine(std::size_t shard_count, std::size_t batch_size, bool pin_workers)
-    : batch_size_(std::max<std::size_t>(1, batch_size))
-    , pin_workers_(pin_workers) {
-    if (shard_count == 0) {
-        shard_count = 1;
+ShardedEngine::ShardedEngine(
+    std::size_t shard_count,
+    std::size_t batch_size,
+    bool pin_workers,
+    IdleStrategy idle,
+    std::vector<std::size_t> worker_cpus)
+    : shards_(std::make_unique<std::unique_ptr<Shard>[]>(kMaxShards))
+    , routes_(std::make_unique<std::atomic<std::uint16_t>[]>(kRouteBuckets))
+    , balanced_ops_(kRouteBuckets, 0)
+    , batch_size_(std::max<std::size_t>(1, batch_size))
+    , pin_workers_(pin_workers)
+    , idle_(idle) {
+    shard_count = std::clamp<std::size_t>(shard_count, 1, kMaxShards);
+    if (pin_workers_) {
+        // Planned for every shard add_shard() may start, so later shards
+        // continue the same placement.
+        if (worker_cpus.empty()) {
+            worker_cpus = plan_worker_cpus(CpuTopology::detect(), kMaxShards, current_cpu());
+        }
+        for (std::size_t i = 0; i < kMaxShards && !worker_cpus.empty(); ++i) {
+            worker_cpus_.push_back(worker_cpus[i % worker_cpus.size()]);
+        }
     }
-
-    shards_.reserve(shard_count);
-    for (std::size_t i = 0; i < shard_count; ++i) {
-        shards_.emplace_back(std::make_unique<Shard>());
+    for (std::size_t bucket = 0; bucket < kRouteBuckets; ++bucket) {
+        routes_[bucket].store(static_cast<std::uint16_t>(bucket % shard_count), std::memory_order_relaxed);
     }
-    producer_owner_thread_ = std::make_unique<std::atomic<std::uint64_t>[]>(shard_count);
     for (std::size_t i = 0; i < shard_count; ++i) {
-        producer_owner_thread_[i].store(0, std::memory_order_relaxed);
-    }
-
-    for (std::size_t i = 0; i < shards_.size(); ++i) {
-        shards_[i]->worker = std::thread([this, i] { worker_loop(i); });
+        start_shard(i);
     }
+    shard_count_.store(shard_count, std::memory_order_release);
 }
 
 ShardedEngine::~ShardedEngine() {
     stop();
 }
 
+// Start shard `shard_idx`'s worker and wait until it has built the shard.
+// The caller publishes it.
+void ShardedEngine::start_shard(std::size_t shard_idx) {
+    std::atomic<bool> ready{false};
+    workers_[shard_idx] = std::thread([this, shard_idx, &ready] { worker_loop(shard_idx, ready); });
+    while (!ready.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+std::optional<ShardedEngine::ProducerToken> ShardedEngine::register_producer() {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    const std::size_t shards = shard_count_.load(std::memory_order_relaxed);
+    for (std::size_t lane = 0; lane < kMaxProducers; ++lane) {
+        if (producer_claimed_[lane].load(std::memory_order_acquire)) {
+            continue;
+        }
+        producer_claimed_[lane].store(true, std::memory_order_relaxed);
+        // First claim of this slot: each worker creates its lane. Later
+        // claims reuse it, so the worker never sees a lane disappear. Once
+        // stopped there is no worker left to ask, nor one to race with.
+        const bool stopped = stopped_.load(std::memory_order_acquire);
+        std::atomic<bool> done{false};
+        for (std::size_t i = 0; i < shards; ++i) {
+            Shard& shard = *shards_[i];
+            if (shard.lane_storage[lane]) {
+                continue;
+            }
+            if (stopped) {
+                add_lane(shard, lane);
+                continue;
+            }
+            post(shard, ControlMessage{ControlType::AddLane, 0, i, {}, &done, lane});
+            while (!done.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            done.store(false, std::memory_order_relaxed);
+        }
+        return ProducerToken(this, lane);
+    }
+    return std::nullopt;
+}
+
+void ShardedEngine::release_producer(std::size_t lane) noexcept {
+    producer_claimed_[lane].store(false, std::memory_order_release);
+}
+
 std::optional<ShardedEngine::OrderHandle> ShardedEngine::submit_add(
+    ProducerToken& producer,
     SymbolId symbol,
     Price price,
     Quantity quantity,
     Side side) noexcept {
     const std::uint64_t client_order_id = next_client_order_id_.fetch_add(1, std::memory_order_relaxed);
-    const std::size_t shard_idx = route(symbol);
     const bool accepted = try_submit(
-        shard_idx, Command{CommandType::Add, symbol, client_order_id, price, quantity, side});
+        producer, Command{CommandType::Add, symbol, client_order_id, price, quantity, side});
     if (!accepted) {
         return std::nullopt;
     }
     return OrderHandle{symbol, client_order_id};
 }
 
-bool ShardedEngine::submit_cancel(OrderHandle handle) noexcept {
+bool ShardedEngine::submit_cancel(ProducerToken& producer, OrderHandle handle) noexcept {
     return try_submit(
-        route(handle.symbol),
-        Command{CommandType::Cancel, handle.symbol, handle.client_order_id, 0, 0, Side::BUY});
+        producer, Command{CommandType::Cancel, handle.symbol, handle.client_order_id, 0, 0, Side::BUY});
 }
 
-bool ShardedEngine::submit_modify(OrderHandle handle, Quantity new_quantity) noexcept {
+bool ShardedEngine::submit_modify(ProducerToken& producer, OrderHandle handle, Quantity new_quantity) noexcept {
     return try_submit(
-        route(handle.symbol),
-        Command{CommandType::Modify, handle.symbol, handle.client_order_id, 0, new_quantity, Side::BUY});
+        producer, Command{CommandType::Modify, handle.symbol, handle.client_order_id, 0, new_quantity, Side::BUY});
 }
 
 void ShardedEngine::stop() {
+    std::lock_guard<std::mutex> lock(control_mutex_);
     bool expected = false;
     if (!stopped_.compare_exchange_strong(expected, true)) {
         return;
     }
 
-    for (std::size_t i = 0; i < shards_.size(); ++i) {
-        Command stop_cmd;
-        stop_cmd.type = CommandType::Stop;
-        while (!shards_[i]->queue.try_push(stop_cmd)) {
-            std::this_thread::yield();
+    const std::size_t shards = shard_count_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < shards; ++i) {
+        Shard& shard = *shards_[i];
+        shard.stop_requested.store(true, std::memory_order_release);
+        // Unconditional: a worker about to park sees either the flag or the
+        // changed wake_seq.
+        shard.wake_seq.fetch_add(1, std::memory_order_seq_cst);
+        park_wake(shard.wake_seq);
+    }
+    for (std::size_t i = 0; i < shards; ++i) {
+        if (workers_[i].joinable()) {
+            workers_[i].join();
         }
     }
+}
+
+const ShardedEngine::Lane& ShardedEngine::lane_of(const ProducerToken& producer, std::size_t shard_idx) const noexcept {
+    return *shards_[shard_idx]->lanes[producer.lane_].load(std::memory_order_relaxed);
+}
+
+std::uint64_t ShardedEngine::submitted(const ProducerToken& producer, std::size_t shard_idx) const noexcept {
+    return lane_of(producer, shard_idx).pushed();
+}
+
+std::uint64_t ShardedEngine::completed(const ProducerToken& producer, std::size_t shard_idx) const noexcept {
+    return lane_of(producer, shard_idx).popped();
+}
+
+void ShardedEngine::wait(const ProducerToken& producer, std::size_t shard_idx, std::uint64_t sequence) const noexcept {
+    // A lane is committed only after its events are queued.
+    const Lane& lane = lane_of(producer, shard_idx);
+    while (lane.popped() < sequence) {
+        std::this_thread::yield();
+    }
+}
+
+std::uint64_t ShardedEngine::submitted(std::size_t shard_idx) const noexcept {
+    const Shard& shard = *shards_[shard_idx];
+    const std::size_t lanes = shard.lane_count.load(std::memory_order_acquire);
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < lanes; ++i) {
+        if (const Lane* lane = shard.lanes[i].load(std::memory_order_acquire)) {
+            total += lane->pushed();
+        }
+    }
+    return total;
+}
+
+std::uint64_t ShardedEngine::completed(std::size_t shard_idx) const noexcept {
+    return shards_[shard_idx]->completed.load(std::memory_order_acquire);
+}
 
-    for (auto& shard : shards_) {
-        if (shard->worker.joinable()) {
-            shard->worker.join();
+void ShardedEngine::flush(std::size_t shard_idx) noexcept {
+    // Lanes complete independently, so a shard-wide count cannot tell which
+    // commands are done: wait for each lane's own sequence instead.
+    Shard& shard = *shards_[shard_idx];
+    const std::size_t lanes = shard.lane_count.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < lanes; ++i) {
+        const Lane* lane = shard.lanes[i].load(std::memory_order_acquire);
+        if (!lane) {
+            continue;
+        }
+        const std::size_t target = lane->pushed();
+        while (lane->popped() < target) {
+            std::this_thread::yield();
         }
     }
 }
 
 void ShardedEngine::flush() noexcept {
-    while (inflight_.load(std::memory_order_acquire) != 0) {
-        std::this_thread::yield();
+    const std::size_t shards = shard_count();
+    for (std::size_t i = 0; i < shards; ++i) {
+        flush(i);
     }
 }
 
 std::size_t ShardedEngine::route(SymbolId symbol) const noexcept {
-    return static_cast<std::size_t>(symbol) % shards_.size();
+    return routes_[symbol & kRouteMask].load(std::memory_order_acquire);
 }
 
-bool ShardedEngine::try_submit(std::size_t shard_idx, const Command& cmd) noexcept {
-    if (stopped_.load(std::memory_order_acquire)) {
+bool ShardedEngine::try_submit(const ProducerToken& producer, const Command& cmd) noexcept {
+    if (LOB_UNLIKELY(producer.engine_ != this || stopped_.load(std::memory_order_acquire))) {
         return false;
     }
 
-    // Enforce SPSC queue ownership: one producer thread per shard queue.
-    const std::uint64_t producer_token = current_thread_token();
-    std::uint64_t owner = producer_owner_thread_[shard_idx].load(std::memory_order_acquire);
-    if (owner == 0) {
-        std::uint64_t expected = 0;
-        producer_owner_thread_[shard_idx].compare_exchange_strong(
-            expected, producer_token, std::memory_order_release, std::memory_order_relaxed);
-        owner = producer_owner_thread_[shard_idx].load(std::memory_order_acquire);
-    }
-    if (owner != producer_token) {
-        return false;
+    // Mark the submit in progress before reading the route; pairs with the
+    // fence in migrate_locked().
+    std::atomic<std::uint64_t>& epoch = submit_epochs_[producer.lane_].value;
+    const std::uint64_t inside = epoch.load(std::memory_order_relaxed) + 1;
+    epoch.store(inside, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    Shard& shard = *shards_[route(cmd.symbol)];
+    const bool pushed = shard.lanes[producer.lane_].load(std::memory_order_relaxed)->try_push(cmd);
+    epoch.store(inside + 1, std::memory_order_release);
+    if (pushed && idle_ == IdleStrategy::Park) {
+        wake(shard);
     }
+    return pushed;
+}
+
+bool ShardedEngine::migrate(SymbolId symbol, std::size_t shard_idx) {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    return migrate_locked(static_cast<std::uint32_t>(symbol & kRouteMask), shard_idx);
+}
 
-    if (!shards_[shard_idx]->queue.try_push(cmd)) {
+bool ShardedEngine::migrate_locked(std::uint32_t bucket, std::size_t shard_idx) {
+    if (stopped_.load(std::memory_order_acquire) || shard_idx >= shard_count_.load(std::memory_order_relaxed)) {
         return false;
     }
-    if (cmd.type != CommandType::Stop) {
-        inflight_.fetch_add(1, std::memory_order_release);
+    const std::size_t from = routes_[bucket].load(std::memory_order_relaxed);
+    if (from == shard_idx) {
+        return true;
     }
+
+    std::atomic<bool> done{false};
+    const auto await = [&done] {
+        while (!done.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+        done.store(false, std::memory_order_relaxed);
+    };
+
+    // 1. The target holds back the bucket's commands from here on.
+    post(*shards_[shard_idx], ControlMessage{ControlType::Expect, bucket, shard_idx, {}, &done});
+    await();
+
+    // 2. Switch the route, then wait out submits that were already inside
+    //    and may have read the old one: afterwards every command sent to the
+    //    old owner for this bucket is in its lanes.
+    routes_[bucket].store(static_cast<std::uint16_t>(shard_idx), std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (SubmitEpoch& epoch : submit_epochs_) {
+        const std::uint64_t seen = epoch.value.load(std::memory_order_acquire);
+        if ((seen & 1) != 0) {
+            while (epoch.value.load(std::memory_order_acquire) == seen) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // 3. The old owner drains, hands the orders over; the target installs.
+    post(*shards_[from], ControlMessage{ControlType::Release, bucket, shard_idx, {}, &done});
+    await();
     return true;
 }
 
-void ShardedEngine::worker_loop(std::size_t shard_idx) {
-    Shard& shard = *shards_[shard_idx];
-    if (pin_workers_) {
-        const std::size_t core = shard_idx % hardware_threads();
-        (void)pin_current_thread_to_core(core);
-    }
+std::uint64_t ShardedEngine::symbol_load(SymbolId symbol) const noexcept {
+    return bucket_load(symbol & kRouteMask);
+}
 
-    std::vector<Command> batch;
-    batch.reserve(batch_size_);
+std::uint64_t ShardedEngine::bucket_load(std::size_t bucket) const noexcept {
+    const std::size_t shards = shard_count_.load(std::memory_order_acquire);
+    std::uint64_t ops = 0;
+    for (std::size_t i = 0; i < shards; ++i) {
+        ops += shards_[i]->bucket_ops[bucket].load(std::memory_order_relaxed);
+    }
+    return ops;
+}
 
-    while (shard.running.load(std::memory_order_acquire)) {
-        batch.clear();
+std::size_t ShardedEngine::rebalance(std::size_t max_moves, double tolerance) {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    const std::size_t shards = shard_count_.load(std::memory_order_relaxed);
+    // Totals first, one shard's counters at a time.
+    std::vector<std::uint64_t> delta(kRouteBuckets, 0);
+    for (std::size_t i = 0; i < shards; ++i) {
+        const std::atomic<std::uint64_t>* counts = shards_[i]->bucket_ops.get();
+        for (std::size_t bucket = 0; bucket < kRouteBuckets; ++bucket) {
+            delta[bucket] += counts[bucket].load(std::memory_order_relaxed);
+        }
+    }
+    std::vector<std::uint64_t> load(shards, 0);
+    std::uint64_t total = 0;
+    for (std::size_t bucket = 0; bucket < kRouteBuckets; ++bucket) {
+        const std::uint64_t ops = delta[bucket];
+        delta[bucket] = ops - balanced_ops_[bucket];
+        balanced_ops_[bucket] = ops;
+        load[routes_[bucket].load(std::memory_order_relaxed)] += delta[bucket];
+        total += delta[bucket];
+    }
 
-        Command cmd;
-        while (batch.size() < batch_size_ && shard.queue.try_pop(cmd)) {
-            batch.push_back(cmd);
-            if (cmd.type == CommandType::Stop) {
-                break;
+    const double limit = (1.0 + tolerance) * static_cast<double>(total) / static_cast<double>(shards);
+    std::size_t moves = 0;
+    while (moves < max_moves) {
+        const auto [cold_it, hot_it] = std::minmax_element(load.begin(), load.end());
+        const auto hot = static_cast<std::size_t>(hot_it - load.begin());
+        const auto cold = static_cast<std::size_t>(cold_it - load.begin());
+        if (static_cast<double>(load[hot]) <= limit) {
+            break;
+        }
+        // The hottest bucket on the busiest shard whose move still narrows
+        // the gap (moving more than the gap just swaps the roles).
+        const std::uint64_t gap = load[hot] - load[cold];
+        std::size_t best = kRouteBuckets;
+        for (std::size_t bucket = 0; bucket < kRouteBuckets; ++bucket) {
+            if (routes_[bucket].load(std::memory_order_relaxed) == hot && delta[bucket] != 0 && delta[bucket] < gap &&
+                (best == kRouteBuckets || delta[bucket] > delta[best])) {
+                best = bucket;
             }
         }
+        if (best == kRouteBuckets || !migrate_locked(static_cast<std::uint32_t>(best), cold)) {
+            break;
+        }
+        load[hot] -= delta[best];
+        load[cold] += delta[best];
+        ++moves;
+    }
+    return moves;
+}
+
+std::optional<std::size_t> ShardedEngine::add_shard() {
+    std::lock_guard<std::mutex> lock(control_mutex_);
+    const std::size_t shard_idx = shard_count_.load(std::memory_order_relaxed);
+    if (stopped_.load(std::memory_order_acquire) || shard_idx == kMaxShards) {
+        return std::nullopt;
+    }
+    start_shard(shard_idx);
+    shard_count_.store(shard_idx + 1, std::memory_order_release);
+    return shard_idx;
+}
+
+void ShardedEngine::post(Shard& shard, ControlMessage message) {
+    {
+        std::lock_guard<std::mutex> lock(shard.control_mutex);
+        shard.control.push_back(std::move(message));
+        shard.control_pending.store(true, std::memory_order_release);
+    }
+    shard.wake_seq.fetch_add(1, std::memory_order_seq_cst);
+    park_wake(shard.wake_seq);
+}
+
+// Producer half of the park handshake. The fence orders the push before the
+// parked check, pairing with the fence in park().
+void ShardedEngine::wake(Shard& shard) noexcept {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (LOB_UNLIKELY(shard.parked.load(std::memory_order_relaxed))) {
+        shard.wake_seq.fetch_add(1, std::memory_order_release);
+        park_wake(shard.wake_seq);
+    }
+}
+
+void ShardedEngine::park(Shard& shard) noexcept {
+    const std::uint32_t seq = shard.wake_seq.load(std::memory_order_acquire);
+    shard.parked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!has_work(shard) && !shard.stop_requested.load(std::memory_order_acquire)) {
+        shard.parks.store(shard.parks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        park_wait(shard.wake_seq, seq);
+    }
+    shard.parked.store(false, std::memory_order_relaxed);
+}
+
+bool ShardedEngine::has_work(const Shard& shard) noexcept {
+    if (shard.control_pending.load(std::memory_order_acquire)) {
+        return true;
+    }
+    const std::size_t lanes = shard.lane_count.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < lanes; ++i) {
+        const Lane* lane = shard.lanes[i].load(std::memory_order_acquire);
+        if (lane && !lane->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
 
-        if (batch.empty()) {
+void ShardedEngine::idle_wait(Shard& shard, IdleBackoff& backoff) const noexcept {
+    switch (idle_) {
+        case IdleStrategy::Spin:
+            cpu_relax();
+            break;
+        case IdleStrategy::Backoff:
+            if (!backoff.pause()) {
+                std::this_thread::yield();
+            }
+            break;
+        case IdleStrategy::Park:
+            if (!backoff.pause()) {
+                // Nothing wakes a parked worker when the consumer frees ring
+                // space, so hold off while events are still backlogged.
+                if (shard.outbox.empty()) {
+                    park(shard);
+                    backoff.reset();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            break;
+        case IdleStrategy::Yield:
+        default:
             std::this_thread::yield();
+            break;
+    }
+}
+
+void ShardedEngine::worker_loop(std::size_t shard_idx, std::atomic<bool>& ready) {
+    // Pin first, then allocate: everything the worker touches below is
+    // first-touched here, on its own CPU's node.
+    std::optional<std::size_t> cpu;
+    if (!worker_cpus_.empty() && pin_current_thread_to_core(worker_cpus_[shard_idx])) {
+        cpu = worker_cpus_[shard_idx];
+    }
+    auto owned = std::make_unique<Shard>();
+    Shard& shard = *owned;
+    shard.cpu = cpu;
+    shard.bucket_ops = std::make_unique<std::atomic<std::uint64_t>[]>(kRouteBuckets);
+    shard.books = std::make_unique<BookRegistry>();
+    // Sized up front so the steady state neither rehashes nor reallocates.
+    shard.client_pool.reserve(kInitialOrders);
+    shard.client_orders.reserve(kInitialOrders);
+    prefault(&shard, sizeof(Shard));
+
+    // A later shard gets a lane for every slot already claimed. start_shard
+    // runs under control_mutex_, so the lane set cannot change meanwhile.
+    if (shard_idx != 0) {
+        const Shard& first = *shards_[0];
+        for (std::size_t lane = 0; lane < kMaxProducers; ++lane) {
+            if (first.lane_storage[lane]) {
+                add_lane(shard, lane);
+            }
+        }
+    }
+    shards_[shard_idx] = std::move(owned);
+    ready.store(true, std::memory_order_release);
+
+    WorkerState state;
+    state.grouped.reserve(batch_size_);
+    state.group_keys.reserve(batch_size_);
+    state.pending.commands.reserve(batch_size_);
+    state.pending.client_order_ids.reserve(batch_size_);
+    state.pending.fill_prices.reserve(64);
+    state.batch_limit = batch_size_;
+
+    IdleBackoff backoff;
+    std::uint64_t last_cycles = read_cycles();
+    while (true) {
+        if (LOB_UNLIKELY(shard.control_pending.load(std::memory_order_acquire))) {
+            handle_control(shard, state);
+        }
+        // Read before polling: anything pushed before stop() is seen below.
+        const bool stopping = shard.stop_requested.load(std::memory_order_acquire);
+        if (poll_lanes(shard, state)) {
+            backoff.reset();
+            const std::uint64_t now = read_cycles();
+            shard.busy_cycles.store(
+                shard.busy_cycles.load(std::memory_order_relaxed) + (now - last_cycles), std::memory_order_relaxed);
+            last_cycles = now;
             continue;
         }
+        if (stopping) {
+            break;
+        }
+        publish_events(shard);
+        idle_wait(shard, backoff);
+        const std::uint64_t now = read_cycles();
+        shard.idle_cycles.store(
+            shard.idle_cycles.load(std::memory_order_relaxed) + (now - last_cycles), std::memory_order_relaxed);
+        last_cycles = now;
+    }
+    publish_events(shard);
+}
 
-        for (const Command& op : batch) {
-            switch (op.type) {
-                case CommandType::Add: {
-                    const auto result = shard.book.add_order(op.price, op.quantity, op.side);
-                    if (result.order_id != 0 && result.remaining_quantity > 0) {
-                        shard.client_to_book_order[op.client_order_id] = result.order_id;
-                    }
-                    inflight_.fetch_sub(1, std::memory_order_release);
+// One fan-in round: a batch from each lane, the starting lane rotating so no
+// producer is always served first. Returns whether anything was applied.
+bool ShardedEngine::poll_lanes(Shard& shard, WorkerState& state) {
+    const std::size_t min_batch = std::min(kMinBatch, batch_size_);
+    const std::size_t lanes = shard.lane_count.load(std::memory_order_acquire);
+    bool busy = false;
+    for (std::size_t n = 0; n < lanes; ++n) {
+        const std::size_t l = (state.first_lane + n) % lanes;
+        Lane* lane = shard.lanes[l].load(std::memory_order_acquire);
+        if (!lane) {
+            continue;
+        }
+        // Commands are read in place and released once their events are
+        // queued: in the ring, or in the outbox while the ring is full.
+        const auto span = lane->peek(state.batch_limit);
+        std::size_t count = span.size;
+        if (LOB_UNLIKELY(!state.incoming.empty())) {
+            // Stop short of a bucket whose orders are still in transit; the
+            // lane resumes from there once they are installed.
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto bucket = static_cast<std::uint32_t>(span.data[i].symbol & kRouteMask);
+                if (std::find(state.incoming.begin(), state.incoming.end(), bucket) != state.incoming.end()) {
+                    count = i;
                     break;
                 }
-                case CommandType::Cancel: {
-                    auto it = shard.client_to_book_order.find(op.client_order_id);
-                    if (it != shard.client_to_book_order.end()) {
-                        if (shard.book.cancel_order(it->second)) {
-                            shard.client_to_book_order.erase(it);
-                        }
+            }
+        }
+        if (count == 0) {
+            continue;
+        }
+        busy = true;
+        process_commands(shard, span.data, count, state);
+        publish_events(shard);
+        lane->commit(count);
+        shard.completed.store(shard.completed.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        shard.batches.store(shard.batches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        // A full poll means the lane is backed up; a mostly empty one means
+        // it is keeping up.
+        if (count == state.batch_limit) {
+            state.batch_limit = std::min(state.batch_limit * 2, batch_size_);
+        } else if (count < state.batch_limit / 4) {
+            state.batch_limit = std::max(state.batch_limit / 2, min_batch);
+        }
+    }
+    state.first_lane = (lanes == 0) ? 0 : (state.first_lane + 1) % lanes;
+    shard.batch_limit.store(state.batch_limit, std::memory_order_relaxed);
+    return busy;
+}
+
+void ShardedEngine::handle_control(Shard& shard, WorkerState& state) {
+    std::vector<ControlMessage> messages;
+    {
+        std::lock_guard<std::mutex> lock(shard.control_mutex);
+        messages.swap(shard.control);
+        shard.control_pending.store(false, std::memory_order_relaxed);
+    }
+    for (ControlMessage& message : messages) {
+        switch (message.type) {
+            case ControlType::Expect:
+                state.incoming.push_back(message.bucket);
+                message.done->store(true, std::memory_order_release);
+                break;
+            case ControlType::Release:
+                release_bucket(shard, state, message);
+                break;
+            case ControlType::Install:
+                install_bucket(shard, message);
+                state.incoming.erase(
+                    std::remove(state.incoming.begin(), state.incoming.end(), message.bucket), state.incoming.end());
+                message.done->store(true, std::memory_order_release);
+                break;
+            case ControlType::AddLane:
+                add_lane(shard, message.lane);
+                message.done->store(true, std::memory_order_release);
+                break;
+        }
+    }
+}
+
+// Runs on the shard's worker, except before it starts or after it exits.
+void ShardedEngine::add_lane(Shard& shard, std::size_t lane) {
+    if (shard.lane_storage[lane]) {
+        return;
+    }
+    shard.lane_storage[lane] = std::make_unique<Lane>();
+    prefault(shard.lane_storage[lane].get(), sizeof(Lane));
+    shard.lanes[lane].store(shard.lane_storage[lane].get(), std::memory_order_release);
+    if (shard.lane_count.load(std::memory_order_relaxed) < lane + 1) {
+        shard.lane_count.store(lane + 1, std::memory_order_release);
+    }
+}
+
+// Old owner's side of a migration. The route already points at the target
+// and no submit still holds the old one, so what is in the lanes now is the
+// last of the bucket's commands here: apply them, then move the resting
+// orders out in queue order.
+void ShardedEngine::release_bucket(Shard& shard, WorkerState& state, ControlMessage& message) {
+    std::array<std::size_t, kMaxProducers> drained_to{};
+    const std::size_t lanes = shard.lane_count.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < lanes; ++i) {
+        if (const Lane* lane = shard.lanes[i].load(std::memory_order_acquire)) {
+            drained_to[i] = lane->pushed();
+        }
+    }
+    for (;;) {
+        bool behind = false;
+        for (std::size_t i = 0; i < lanes; ++i) {
+            const Lane* lane = shard.lanes[i].load(std::memory_order_acquire);
+            behind |= lane && lane->popped() < drained_to[i];
+        }
+        if (!behind) {
+            break;
+        }
+        if (!poll_lanes(shard, state)) {
+            std::this_thread::yield();
+        }
+    }
+
+    ControlMessage install{ControlType::Install, message.bucket, message.target, {}, message.done};
+    BookRegistry& registry = *shard.books;
+    for (std::uint64_t symbol = message.bucket; symbol < registry.symbol_capacity(); symbol += kRouteBuckets) {
+        const auto id = static_cast<SymbolId>(symbol);
+        const BookRegistry::book_type* book = registry.find(id);
+        if (!book) {
+            continue;
+        }
+        book->for_each_order([&](OrderId order_id, Side side, Price price, Quantity quantity, Quantity remaining) {
+            ClientOrder* order = find_by_book_id(shard, id, order_id);
+            if (!order) {
+                return;
+            }
+            install.orders.push_back(MovedOrder{id, order->client_order_id, side, price, quantity, remaining});
+            forget_order(shard, order);
+        });
+        registry.release(id);
+        if (symbol < shard.book_orders.size()) {
+            shard.book_orders[symbol].reset();
+        }
+    }
+    post(*shards_[message.target], std::move(install));
+}
+
+// Target's side: rebuild the books; restoring in visit order keeps every
+// level's queue and each order's filled amount.
+void ShardedEngine::install_bucket(Shard& shard, const ControlMessage& message) {
+    for (const MovedOrder& order : message.orders) {
+        auto& book = shard.books->book(order.symbol);
+        const auto result = book.restore_order(order.price, order.quantity, order.remaining, order.side);
+        if (LOB_UNLIKELY(result.order_id == 0)) {
+            // Only if the registry cannot allocate: the orders came from a
+            // consistent book.
+            continue;
+        }
+        track_order(shard, ClientOrder{order.client_order_id, order.symbol, order.side, result.order_id, order.price,
+                                       order.quantity, order.remaining});
+    }
+}
+
+ShardedEngine::ClientOrder* ShardedEngine::track_order(Shard& shard, const ClientOrder& order) {
+    ClientOrder* record = shard.client_pool.create(order);
+    shard.client_orders.insert(order.client_order_id, record);
+    if (order.symbol >= shard.book_orders.size()) {
+        shard.book_orders.resize(static_cast<std::size_t>(order.symbol) + 1);
+    }
+    std::unique_ptr<ClientIndex>& by_book_id = shard.book_orders[order.symbol];
+    if (!by_book_id) {
+        by_book_id = std::make_unique<ClientIndex>();
+    }
+    by_book_id->insert(order.book_order_id, record);
+    return record;
+}
+
+void ShardedEngine::forget_order(Shard& shard, ClientOrder* order) noexcept {
+    shard.client_orders.erase(order->client_order_id);
+    shard.book_orders[order->symbol]->erase(order->book_order_id);
+    shard.client_pool.destroy(order);
+}
+
+ShardedEngine::ClientOrder* ShardedEngine::find_by_book_id(
+    const Shard& shard,
+    SymbolId symbol,
+    OrderId order_id) noexcept {
+    if (symbol >= shard.book_orders.size() || !shard.book_orders[symbol]) {
+        return nullptr;
+    }
+    return shard.book_orders[symbol]->find(order_id);
+}
+
+void ShardedEngine::process_commands(Shard& shard, const Command* ops, std::size_t count, WorkerState& state) {
+    PendingBatch& pending = state.pending;
+
+    // Books are independent, so group the batch by symbol (keeping each
+    // symbol's own order) and give each book one apply_batch run.
+    bool mixed = false;
+    for (std::size_t i = 1; i < count && !mixed; ++i) {
+        mixed = ops[i].symbol != ops[0].symbol;
+    }
+    if (mixed) {
+        state.group_keys.clear();
+        for (std::size_t i = 0; i < count; ++i) {
+            state.group_keys.push_back((static_cast<std::uint64_t>(ops[i].symbol) << 32) | i);
+        }
+        std::sort(state.group_keys.begin(), state.group_keys.end());
+        state.grouped.clear();
+        for (const std::uint64_t key : state.group_keys) {
+            state.grouped.push_back(ops[static_cast<std::uint32_t>(key)]);
+        }
+        ops = state.grouped.data();
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const Command& op = ops[i];
+        if (op.symbol != pending.symbol) {
+            apply_pending(shard, pending);
+            pending.symbol = op.symbol;
+        }
+
+        if (op.type == CommandType::Add) {
+            pending.commands.push_back(
+                BookCommand{BookAction::ADD, op.side, OrderType::LIMIT, 0, op.price, op.quantity});
+            pending.client_order_ids.push_back(op.client_order_id);
+            continue;
+        }
+
+        ClientOrder* order = shard.client_orders.find(op.client_order_id);
+        if (!order && !pending.commands.empty()) {
+            // The order may be an add earlier in this batch: apply what
+            // is pending so its book id is known.
+            apply_pending(shard, pending);
+            order = shard.client_orders.find(op.client_order_id);
+        }
+        // Client ids are engine-wide, so a handle naming another symbol
+        // can still find an order here; it must not touch that order.
+        if (!order || order->symbol != op.symbol) {
+            emit(shard, Event{EventType::Reject, op.side, op.symbol, op.client_order_id, 0, 0, op.quantity});
+            continue;
+        }
+        if (op.type == CommandType::Cancel) {
+            pending.commands.push_back(
+                BookCommand{BookAction::CANCEL, order->side, OrderType::LIMIT, order->book_order_id, 0, 0});
+        } else if (op.quantity > order->quantity) {
+            // Growing the total keeps priority and cannot leave nothing.
+            pending.commands.push_back(
+                BookCommand{BookAction::MODIFY, order->side, OrderType::LIMIT, order->book_order_id, 0, op.quantity});
+        } else {
+            // Shrinking goes through replace at the same price, which keeps
+            // priority but cancels outright at or below the filled amount
+            // (as of when the book applies it) instead of leaving an order
+            // with nothing remaining.
+            pending.commands.push_back(BookCommand{
+                BookAction::REPLACE, order->side, OrderType::LIMIT, order->book_order_id, order->price, op.quantity});
+        }
+        if (op.type == CommandType::Modify) {
+            order->quantity = op.quantity;
+        }
+        pending.client_order_ids.push_back(op.client_order_id);
+    }
+    apply_pending(shard, pending);
+}
+
+void ShardedEngine::apply_pending(Shard& shard, PendingBatch& pending) {
+    if (pending.commands.empty()) {
+        return;
+    }
+
+    // Per-bucket command counts feed rebalance().
+    std::atomic<std::uint64_t>& ops = shard.bucket_ops[pending.symbol & kRouteMask];
+    ops.store(ops.load(std::memory_order_relaxed) + pending.commands.size(), std::memory_order_relaxed);
+
+    using Book = BookRegistry::book_type;
+
+    // Turns book results into events and keeps the client order records
+    // current; fills can complete orders resting from earlier commands.
+    struct ResultSink {
+        Shard& shard;
+        PendingBatch& pending;
+        const Book& book;
+        std::size_t next_index;     // command the next fills belong to
+
+        void on_fill(const Fill& fill) {
+            const BookCommand& cmd = pending.commands[next_index];
+            const OrderId maker = (cmd.side == Side::BUY) ? fill.sell_order_id : fill.buy_order_id;
+            std::uint64_t maker_client = 0;
+            if (ClientOrder* order = find_by_book_id(shard, pending.symbol, maker)) {
+                maker_client = order->client_order_id;
+                order->remaining -= fill.quantity;
+                if (order->remaining == 0) {
+                    forget_order(shard, order);
+                }
+            }
+            emit(shard, Event{EventType::Fill, cmd.side, pending.symbol, pending.client_order_ids[next_index],
+                              maker_client, fill.price, fill.quantity});
+            if (pending.fill_prices.empty() || pending.fill_prices.back() != fill.price) {
+                pending.fill_prices.push_back(fill.price);
+            }
+        }
+
+        void level_update(Side side, Price price) {
+            const Quantity quantity = (side == Side::BUY) ? book.get_bid_quantity_at(price)
+                                                          : book.get_ask_quantity_at(price);
+            emit(shard, Event{EventType::LevelUpdate, side, pending.symbol, 0, 0, price, quantity});
+        }
+
+        void on_result(std::size_t index, const Book::AddSummary& result) {
+            const BookCommand& cmd = pending.commands[index];
+            const std::uint64_t client_order_id = pending.client_order_ids[index];
+            switch (cmd.action) {
+                case BookAction::ADD:
+                    if (result.order_id == 0) {
+                        emit(shard, Event{EventType::Reject, cmd.side, pending.symbol, client_order_id, 0,
+                                          cmd.price, cmd.quantity});
+                        break;
+                    }
+                    emit(shard, Event{EventType::Ack, cmd.side, pending.symbol, client_order_id, 0,
+                                      cmd.price, result.remaining_quantity});
+                    if (result.remaining_quantity > 0) {
+                        track_order(shard, ClientOrder{client_order_id, pending.symbol, cmd.side, result.order_id,
+                                                       cmd.price, cmd.quantity, result.remaining_quantity});
+                        level_update(cmd.side, cmd.price);
                     }
-                    inflight_.fetch_sub(1, std::memory_order_release);
                     break;
-                }
-                case CommandType::Modify: {
-                    auto it = shard.client_to_book_order.find(op.client_order_id);
-                    if (it != shard.client_to_book_order.end()) {
-                        static_cast<void>(shard.book.modify_order(it->second, op.quantity));
+                case BookAction::CANCEL:
+                case BookAction::MODIFY:
+                case BookAction::REPLACE: {
+                    ClientOrder* order = shard.client_orders.find(client_order_id);
+                    if (result.order_id == 0 || !order) {
+                        const Side side = order ? order->side : cmd.side;
+                        emit(shard, Event{EventType::Reject, side, pending.symbol, client_order_id, 0, 0,
+                                          cmd.quantity});
+                        break;
+                    }
+                    const Side side = order->side;
+                    const Price price = order->price;
+                    if (cmd.action == BookAction::CANCEL) {
+                        emit(shard, Event{EventType::CancelAck, side, pending.symbol, client_order_id, 0,
+                                          price, order->remaining});
+                        order->remaining = 0;
+                    } else {
+                        // REPLACE reports 0 when it cancelled the order.
+                        order->remaining = result.remaining_quantity;
+                        emit(shard, Event{EventType::ModifyAck, side, pending.symbol, client_order_id, 0,
+                                          price, order->remaining});
                     }
-                    inflight_.fetch_sub(1, std::memory_order_release);
+                    if (order->remaining == 0) {
+                        forget_order(shard, order);
+                    }
+                    level_update(side, price);
                     break;
                 }
-                case CommandType::Stop:
-                    shard.running.store(false, std::memory_order_release);
+                default:
                     break;
             }
+
+            const Side contra = (cmd.side == Side::BUY) ? Side::SELL : Side::BUY;
+            for (const Price price : pending.fill_prices) {
+                level_update(contra, price);
+            }
+            pending.fill_prices.clear();
+            next_index = index + 1;
+        }
+    };
+
+    Book& book = shard.books->book(pending.symbol);
+    ResultSink sink{shard, pending, book, 0};
+    book.apply_batch(pending.commands.data(), pending.commands.size(), sink);
+    pending.commands.clear();
+    pending.client_order_ids.clear();
+}
+
+void ShardedEngine::emit(Shard& shard, const Event& event) noexcept {
+    if (LOB_UNLIKELY(!shard.outbox.try_push(event))) {
+        shard.dropped_events.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Move as much of the backlog into the ring as fits; never waits. The
+// backlog is read in place, one contiguous run at a time.
+void ShardedEngine::publish_events(Shard& shard) noexcept {
+    for (;;) {
+        const auto backlog = shard.outbox.peek();
+        if (backlog.size == 0) {
+            return;
+        }
+        const std::size_t pushed = shard.events.try_push_n(backlog.data, backlog.size);
+        shard.outbox.commit(pushed);
+        if (pushed < backlog.size) {
+            return;
         }
     }
 }
 
+std::size_t ShardedEngine::poll_events(std::size_t shard_idx, Event* out, std::size_t max) noexcept {
+    return shards_[shard_idx]->events.try_pop_n(out, max);
+}
+
+std::uint64_t ShardedEngine::dropped_events(std::size_t shard_idx) const noexcept {
+    return shards_[shard_idx]->dropped_events.load(std::memory_order_relaxed);
+}
+
+std::optional<std::size_t> ShardedEngine::worker_cpu(std::size_t shard_idx) const noexcept {
+    return shards_[shard_idx]->cpu;
+}
+
+ShardedEngine::WorkerStats ShardedEngine::worker_stats(std::size_t shard_idx) const noexcept {
+    const Shard& shard = *shards_[shard_idx];
+    return WorkerStats{
+        shard.busy_cycles.load(std::memory_order_relaxed),
+        shard.idle_cycles.load(std::memory_order_relaxed),
+        shard.batches.load(std::memory_order_relaxed),
+        shard.parks.load(std::memory_order_relaxed),
+        shard.batch_limit.load(std::memory_order_relaxed),
+    };
+}
+
 }  // namespace lob::engine
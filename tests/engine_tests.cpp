@@ -0,0 +1,633 @@
+#include "engine_tests.hpp"
+#include "test_framework.hpp"
+#include <lob/engine/sharded_engine.hpp>
+#include <lob/engine/thread_pinning.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace lob;
+using lob::engine::ShardedEngine;
+
+namespace {
+
+using Event = ShardedEngine::Event;
+using EventType = ShardedEngine::EventType;
+
+// Everything the engine has produced so far, shard by shard.
+std::vector<Event> drain(ShardedEngine& engine) {
+    engine.flush();
+    std::vector<Event> events;
+    Event buffer[256];
+    for (std::size_t shard = 0; shard < engine.shard_count(); ++shard) {
+        while (const std::size_t n = engine.poll_events(shard, buffer, 256)) {
+            events.insert(events.end(), buffer, buffer + n);
+        }
+    }
+    return events;
+}
+
+std::vector<Event> of_type(const std::vector<Event>& events, EventType type) {
+    std::vector<Event> matching;
+    for (const Event& event : events) {
+        if (event.type == type) {
+            matching.push_back(event);
+        }
+    }
+    return matching;
+}
+
+}  // namespace
+
+void test_engine_symbols_do_not_trade() {
+    // Symbols 1 and 9 share a shard, but never a book.
+    ShardedEngine engine(2, 256, false);
+    auto producer = engine.register_producer();
+    assert(producer && engine.shard_of(1) == engine.shard_of(9));
+    
+    auto bid = engine.submit_add(*producer, 1, 10000, 10, Side::BUY);
+    auto ask = engine.submit_add(*producer, 9, 10000, 10, Side::SELL);
+    assert(bid && ask);
+    
+    std::vector<Event> events = drain(engine);
+    assert(of_type(events, EventType::Fill).empty());
+    const std::vector<Event> acks = of_type(events, EventType::Ack);
+    assert(acks.size() == 2);
+    assert(acks[0].quantity == 10 && acks[1].quantity == 10);
+    
+    // Same symbol does trade.
+    auto taker = engine.submit_add(*producer, 1, 10000, 4, Side::SELL);
+    assert(taker);
+    events = drain(engine);
+    const std::vector<Event> fills = of_type(events, EventType::Fill);
+    assert(fills.size() == 1);
+    assert(fills[0].symbol == 1 && fills[0].quantity == 4);
+    assert(fills[0].client_order_id == taker->client_order_id);
+    assert(fills[0].contra_order_id == bid->client_order_id);
+}
+
+void test_engine_rejects_foreign_handle() {
+    ShardedEngine engine(1, 256, false);
+    auto producer = engine.register_producer();
+    auto first = engine.submit_add(*producer, 1, 10000, 10, Side::BUY);
+    auto second = engine.submit_add(*producer, 2, 10000, 10, Side::BUY);
+    assert(first && second);
+    (void)drain(engine);
+    
+    // first's client id under symbol 2: rejected, nothing touched.
+    const ShardedEngine::OrderHandle foreign{2, first->client_order_id};
+    assert(engine.submit_cancel(*producer, foreign));
+    assert(engine.submit_modify(*producer, foreign, 5));
+    std::vector<Event> events = drain(engine);
+    assert(events.size() == 2);
+    for (const Event& event : events) {
+        assert(event.type == EventType::Reject);
+        assert(event.symbol == 2 && event.client_order_id == first->client_order_id);
+    }
+    
+    // Both orders still rest with their full quantity.
+    assert(engine.submit_add(*producer, 1, 10000, 10, Side::SELL));
+    assert(engine.submit_cancel(*producer, *second));
+    events = drain(engine);
+    const std::vector<Event> fills = of_type(events, EventType::Fill);
+    assert(fills.size() == 1 && fills[0].contra_order_id == first->client_order_id && fills[0].quantity == 10);
+    const std::vector<Event> cancels = of_type(events, EventType::CancelAck);
+    assert(cancels.size() == 1 && cancels[0].client_order_id == second->client_order_id);
+    assert(cancels[0].quantity == 10);
+}
+
+void test_engine_rejects_unknown_orders() {
+    ShardedEngine engine(2, 256, false);
+    auto producer = engine.register_producer();
+    
+    assert(engine.submit_cancel(*producer, ShardedEngine::OrderHandle{3, 12345}));
+    assert(engine.submit_modify(*producer, ShardedEngine::OrderHandle{4, 12345}, 10));
+    std::vector<Event> events = drain(engine);
+    assert(events.size() == 2);
+    assert(events[0].type == EventType::Reject && events[1].type == EventType::Reject);
+    
+    // A cancelled order is unknown from then on.
+    auto order = engine.submit_add(*producer, 3, 10000, 10, Side::SELL);
+    assert(order);
+    assert(engine.submit_cancel(*producer, *order));
+    assert(engine.submit_cancel(*producer, *order));
+    events = drain(engine);
+    assert(of_type(events, EventType::CancelAck).size() == 1);
+    const std::vector<Event> rejects = of_type(events, EventType::Reject);
+    assert(rejects.size() == 1 && rejects[0].client_order_id == order->client_order_id);
+}
+
+void test_engine_modify_below_filled_removes_order() {
+    ShardedEngine engine(1, 256, false);
+    auto producer = engine.register_producer();
+    auto bid = engine.submit_add(*producer, 1, 10000, 10, Side::BUY);
+    assert(bid && engine.submit_add(*producer, 1, 10000, 6, Side::SELL));
+    (void)drain(engine);
+    
+    // 6 of 10 filled: a new total of 5 leaves nothing, so the order goes.
+    assert(engine.submit_modify(*producer, *bid, 5));
+    std::vector<Event> events = drain(engine);
+    std::vector<Event> acks = of_type(events, EventType::ModifyAck);
+    assert(acks.size() == 1 && acks[0].client_order_id == bid->client_order_id && acks[0].quantity == 0);
+    
+    // Nothing left to trade against or to cancel.
+    auto ask = engine.submit_add(*producer, 1, 10000, 10, Side::SELL);
+    assert(ask && engine.submit_cancel(*producer, *bid));
+    events = drain(engine);
+    assert(of_type(events, EventType::Fill).empty());
+    assert(of_type(events, EventType::Reject).size() == 1);
+    
+    // Shrinking and growing an order that stays.
+    assert(engine.submit_modify(*producer, *ask, 7));
+    assert(engine.submit_modify(*producer, *ask, 12));
+    events = drain(engine);
+    acks = of_type(events, EventType::ModifyAck);
+    assert(acks.size() == 2 && acks[0].quantity == 7 && acks[1].quantity == 12);
+    assert(engine.submit_add(*producer, 1, 10000, 20, Side::BUY));
+    events = drain(engine);
+    const std::vector<Event> fills = of_type(events, EventType::Fill);
+    assert(fills.size() == 1 && fills[0].contra_order_id == ask->client_order_id && fills[0].quantity == 12);
+    
+    // The fill and the modify in one batch: the filled amount is the one
+    // the book sees when it applies the modify.
+    auto late = engine.submit_add(*producer, 2, 10000, 10, Side::BUY);
+    assert(late && engine.submit_add(*producer, 2, 10000, 6, Side::SELL));
+    assert(engine.submit_modify(*producer, *late, 5));
+    events = drain(engine);
+    acks = of_type(events, EventType::ModifyAck);
+    assert(acks.size() == 1 && acks[0].quantity == 0);
+    assert(engine.submit_add(*producer, 2, 10000, 10, Side::SELL));
+    assert(of_type(drain(engine), EventType::Fill).empty());
+}
+
+void test_engine_event_contents() {
+    ShardedEngine engine(1, 256, false);
+    auto producer = engine.register_producer();
+    
+    auto ask = engine.submit_add(*producer, 5, 10100, 10, Side::SELL);
+    assert(ask);
+    std::vector<Event> events = drain(engine);
+    assert(events.size() == 2);
+    assert(events[0].type == EventType::Ack && events[0].side == Side::SELL && events[0].symbol == 5);
+    assert(events[0].client_order_id == ask->client_order_id);
+    assert(events[0].price == 10100 && events[0].quantity == 10);
+    assert(events[1].type == EventType::LevelUpdate && events[1].side == Side::SELL);
+    assert(events[1].client_order_id == 0 && events[1].price == 10100 && events[1].quantity == 10);
+    
+    // Fills, then the ack, then level updates.
+    auto bid = engine.submit_add(*producer, 5, 10100, 4, Side::BUY);
+    assert(bid);
+    events = drain(engine);
+    assert(events.size() == 3);
+    assert(events[0].type == EventType::Fill && events[0].side == Side::BUY);
+    assert(events[0].client_order_id == bid->client_order_id && events[0].contra_order_id == ask->client_order_id);
+    assert(events[0].price == 10100 && events[0].quantity == 4);
+    assert(events[1].type == EventType::Ack && events[1].client_order_id == bid->client_order_id);
+    assert(events[1].quantity == 0);
+    assert(events[2].type == EventType::LevelUpdate && events[2].side == Side::SELL && events[2].quantity == 6);
+    
+    // New total 8 with 4 filled leaves 4.
+    assert(engine.submit_modify(*producer, *ask, 8));
+    events = drain(engine);
+    assert(events.size() == 2);
+    assert(events[0].type == EventType::ModifyAck && events[0].client_order_id == ask->client_order_id);
+    assert(events[0].side == Side::SELL && events[0].price == 10100 && events[0].quantity == 4);
+    assert(events[1].type == EventType::LevelUpdate && events[1].quantity == 4);
+    
+    assert(engine.submit_cancel(*producer, *ask));
+    assert(engine.submit_cancel(*producer, *ask));
+    events = drain(engine);
+    assert(events.size() == 3);
+    assert(events[0].type == EventType::CancelAck && events[0].client_order_id == ask->client_order_id);
+    assert(events[0].price == 10100 && events[0].quantity == 4);
+    assert(events[1].type == EventType::LevelUpdate && events[1].price == 10100 && events[1].quantity == 0);
+    assert(events[2].type == EventType::Reject && events[2].client_order_id == ask->client_order_id);
+    assert(engine.dropped_events(0) == 0);
+}
+
+void test_engine_drops_events_past_backlog() {
+    // Nobody polls: the ring and the worker's backlog fill, the rest is
+    // dropped and counted. Each resting add yields an Ack and a LevelUpdate.
+    ShardedEngine engine(1, 256, false);
+    auto producer = engine.register_producer();
+    constexpr std::size_t kAdds = 20000;
+    for (std::size_t i = 0; i < kAdds; ++i) {
+        while (!engine.submit_add(*producer, 1, 10000 - static_cast<Price>(i % 100), 1, Side::BUY)) {
+            std::this_thread::yield();
+        }
+    }
+    engine.flush();
+    const std::uint64_t dropped = engine.dropped_events(0);
+    assert(dropped > 0 && dropped < 2 * kAdds);
+    
+    // Everything not dropped arrives, in order, as the backlog drains.
+    std::uint64_t received = 0;
+    std::uint64_t acks = 0;
+    Event buffer[512];
+    while (received + dropped < 2 * kAdds) {
+        const std::size_t n = engine.poll_events(0, buffer, 512);
+        for (std::size_t i = 0; i < n; ++i) {
+            acks += buffer[i].type == EventType::Ack ? 1 : 0;
+        }
+        received += n;
+        if (n == 0) {
+            std::this_thread::yield();
+        }
+    }
+    assert(received + dropped == 2 * kAdds);
+    assert(acks > 0 && engine.dropped_events(0) == dropped);
+    
+    // Room again: new events flow.
+    auto later = engine.submit_add(*producer, 2, 10000, 1, Side::BUY);
+    assert(later);
+    const std::vector<Event> events = drain(engine);
+    assert(events.size() == 2 && events[0].client_order_id == later->client_order_id);
+}
+
+void test_engine_flush_with_producers() {
+    ShardedEngine engine(2, 64, false);
+    constexpr std::size_t kProducers = 3;
+    constexpr std::size_t kOrders = 1000;
+    std::vector<ShardedEngine::ProducerToken> tokens;
+    for (std::size_t p = 0; p < kProducers; ++p) {
+        auto token = engine.register_producer();
+        assert(token);
+        tokens.push_back(std::move(*token));
+    }
+    
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&engine, &token = tokens[p], p] {
+            for (std::size_t i = 0; i < kOrders; ++i) {
+                const auto symbol = static_cast<lob::engine::SymbolId>(i % 8);
+                const Side side = (p % 2 == 0) ? Side::BUY : Side::SELL;
+                const Price price = (side == Side::BUY) ? 9000 : 11000;
+                while (!engine.submit_add(token, symbol, price, 1, side)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    
+    // flush() while producers run covers everything submitted before it.
+    std::vector<std::uint64_t> before;
+    for (std::size_t shard = 0; shard < engine.shard_count(); ++shard) {
+        for (const auto& token : tokens) {
+            before.push_back(engine.submitted(token, shard));
+        }
+    }
+    engine.flush();
+    std::size_t k = 0;
+    for (std::size_t shard = 0; shard < engine.shard_count(); ++shard) {
+        for (const auto& token : tokens) {
+            assert(engine.completed(token, shard) >= before[k++]);
+        }
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    // Once quiet, every count has caught up, per token and per shard.
+    engine.flush();
+    std::uint64_t total = 0;
+    for (std::size_t shard = 0; shard < engine.shard_count(); ++shard) {
+        std::uint64_t per_token = 0;
+        for (const auto& token : tokens) {
+            const std::uint64_t submitted = engine.submitted(token, shard);
+            engine.wait(token, shard, submitted);
+            assert(engine.completed(token, shard) == submitted);
+            per_token += submitted;
+        }
+        assert(engine.submitted(shard) == per_token && engine.completed(shard) == per_token);
+        total += per_token;
+    }
+    assert(total == kProducers * kOrders);
+    
+    // Nothing was held back, so every command's ack is already pollable.
+    const std::vector<Event> events = drain(engine);
+    assert(of_type(events, EventType::Ack).size() == kProducers * kOrders);
+}
+
+void test_engine_producer_order_preserved() {
+    // Each producer adds and at once cancels through its own token, no
+    // flush in between: per-lane order means the add is always seen first.
+    ShardedEngine engine(2, 32, false);
+    constexpr std::size_t kProducers = 3;
+    constexpr std::size_t kOrders = 1000;
+    std::vector<ShardedEngine::ProducerToken> tokens;
+    for (std::size_t p = 0; p < kProducers; ++p) {
+        auto token = engine.register_producer();
+        assert(token);
+        tokens.push_back(std::move(*token));
+    }
+    std::vector<std::vector<std::uint64_t>> ids(kProducers);
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&engine, &token = tokens[p], &mine = ids[p]] {
+            for (std::size_t i = 0; i < kOrders; ++i) {
+                const auto symbol = static_cast<lob::engine::SymbolId>(i % 4);
+                std::optional<ShardedEngine::OrderHandle> handle;
+                while (!(handle = engine.submit_add(token, symbol, 10000 - static_cast<Price>(i % 50), 1, Side::BUY))) {
+                    std::this_thread::yield();
+                }
+                mine.push_back(handle->client_order_id);
+                while (!engine.submit_cancel(token, *handle)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    
+    const std::vector<Event> events = drain(engine);
+    assert(of_type(events, EventType::Reject).empty());
+    assert(of_type(events, EventType::Ack).size() == kProducers * kOrders);
+    assert(of_type(events, EventType::CancelAck).size() == kProducers * kOrders);
+    
+    // A producer's client ids rise in its submit order; its acks for each
+    // symbol come out in that order too.
+    for (std::size_t p = 0; p < kProducers; ++p) {
+        std::vector<std::uint64_t> last(4, 0);
+        std::size_t seen = 0;
+        for (const Event& event : events) {
+            if (event.type != EventType::Ack ||
+                !std::binary_search(ids[p].begin(), ids[p].end(), event.client_order_id)) {
+                continue;
+            }
+            std::uint64_t& previous = last[event.symbol];
+            assert(event.client_order_id > previous);
+            previous = event.client_order_id;
+            ++seen;
+        }
+        assert(seen == kOrders);
+    }
+}
+
+void test_engine_park_wakes_on_submit() {
+    ShardedEngine engine(1, 64, false, lob::engine::IdleStrategy::Park);
+    auto producer = engine.register_producer();
+    
+    // Give the worker time to park before each submit; a lost wake shows
+    // up as a command that never completes.
+    constexpr int kRounds = 200;
+    for (int round = 0; round < kRounds; ++round) {
+        std::this_thread::sleep_for(std::chrono::microseconds(round % 4 == 0 ? 2000 : 50));
+        assert(engine.submit_add(*producer, 1, 10000 - round % 50, 1, Side::BUY));
+        const std::uint64_t target = engine.submitted(*producer, 0);
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (engine.completed(*producer, 0) < target) {
+            assert(std::chrono::steady_clock::now() < deadline);
+            std::this_thread::yield();
+        }
+    }
+    const ShardedEngine::WorkerStats stats = engine.worker_stats(0);
+    assert(stats.parks > 0);
+    assert(stats.batches >= static_cast<std::uint64_t>(kRounds));
+    
+    // One command per poll keeps the adaptive limit at its floor.
+    assert(stats.batch_limit == 8);
+    assert(of_type(drain(engine), EventType::Ack).size() == static_cast<std::size_t>(kRounds));
+}
+
+void test_engine_orders_survive_migration() {
+    ShardedEngine engine(2, 256, false);
+    auto producer = engine.register_producer();
+    const lob::engine::SymbolId symbol = 4;
+    assert(engine.shard_of(symbol) == 0);
+    
+    auto first = engine.submit_add(*producer, symbol, 10000, 10, Side::BUY);
+    auto second = engine.submit_add(*producer, symbol, 10000, 10, Side::BUY);
+    auto deeper = engine.submit_add(*producer, symbol, 9990, 5, Side::BUY);
+    assert(first && second && deeper);
+    assert(engine.submit_add(*producer, symbol, 10000, 4, Side::SELL));
+    (void)drain(engine);
+    
+    assert(engine.migrate(symbol, 1));
+    assert(engine.shard_of(symbol) == 1);
+    
+    // Same queue and filled amounts on the new shard: first (6 left) is
+    // still ahead of second, and modify still counts its filled part.
+    assert(engine.submit_modify(*producer, *first, 8));
+    assert(engine.submit_cancel(*producer, *deeper));
+    assert(engine.submit_add(*producer, symbol, 10000, 7, Side::SELL));
+    Event buffer[32];
+    assert(engine.poll_events(0, buffer, 32) == 0);
+    const std::vector<Event> events = drain(engine);
+    const std::vector<Event> modified = of_type(events, EventType::ModifyAck);
+    assert(modified.size() == 1 && modified[0].quantity == 4);
+    const std::vector<Event> cancelled = of_type(events, EventType::CancelAck);
+    assert(cancelled.size() == 1 && cancelled[0].client_order_id == deeper->client_order_id);
+    assert(cancelled[0].quantity == 5);
+    const std::vector<Event> fills = of_type(events, EventType::Fill);
+    assert(fills.size() == 2);
+    assert(fills[0].contra_order_id == first->client_order_id && fills[0].quantity == 4);
+    assert(fills[1].contra_order_id == second->client_order_id && fills[1].quantity == 3);
+    
+    // A shard added later can take the symbol over as well.
+    const std::optional<std::size_t> added = engine.add_shard();
+    assert(added && *added == 2 && engine.shard_count() == 3);
+    assert(engine.migrate(symbol, *added));
+    assert(engine.submit_cancel(*producer, *second));
+    engine.flush();
+    assert(engine.poll_events(*added, buffer, 32) == 2);
+    assert(buffer[0].type == EventType::CancelAck && buffer[0].quantity == 7);
+    assert(!engine.migrate(symbol, 7));
+}
+
+void test_engine_commands_during_migration() {
+    // A producer keeps adding and cancelling while the buckets it uses move
+    // back and forth: every command gets exactly one response.
+    ShardedEngine engine(2, 32, false);
+    auto producer = engine.register_producer();
+    constexpr std::size_t kOrders = 3000;
+    std::atomic<bool> done{false};
+    std::thread feeder([&engine, &token = *producer, &done] {
+        for (std::size_t i = 0; i < kOrders; ++i) {
+            const auto symbol = static_cast<lob::engine::SymbolId>(i % 3);
+            std::optional<ShardedEngine::OrderHandle> handle;
+            while (!(handle = engine.submit_add(token, symbol, 10000 - static_cast<Price>(i % 20), 1, Side::BUY))) {
+                std::this_thread::yield();
+            }
+            while (!engine.submit_cancel(token, *handle)) {
+                std::this_thread::yield();
+            }
+        }
+        done.store(true);
+    });
+    
+    std::size_t moves = 0;
+    while (!done.load()) {
+        const auto symbol = static_cast<lob::engine::SymbolId>(moves % 3);
+        assert(engine.migrate(symbol, 1 - engine.shard_of(symbol)));
+        ++moves;
+    }
+    feeder.join();
+    
+    const std::vector<Event> events = drain(engine);
+    assert(moves > 0);
+    assert(of_type(events, EventType::Reject).empty());
+    assert(of_type(events, EventType::Ack).size() == kOrders);
+    assert(of_type(events, EventType::CancelAck).size() == kOrders);
+    for (std::size_t shard = 0; shard < engine.shard_count(); ++shard) {
+        assert(engine.dropped_events(shard) == 0);
+    }
+}
+
+void test_engine_rebalance_moves_hot_buckets() {
+    // Symbols 0, 2, 4 and 6 all start on shard 0 of 2.
+    ShardedEngine engine(2, 256, false);
+    auto producer = engine.register_producer();
+    std::vector<ShardedEngine::OrderHandle> resting;
+    for (lob::engine::SymbolId symbol = 0; symbol < 8; symbol += 2) {
+        for (int i = 0; i < 50; ++i) {
+            auto handle = engine.submit_add(*producer, symbol, 10000 - i, 1, Side::BUY);
+            assert(handle);
+            resting.push_back(*handle);
+        }
+    }
+    engine.flush();
+    assert(engine.symbol_load(0) == 50);
+    
+    assert(engine.rebalance() > 0);
+    std::size_t on_second = 0;
+    for (lob::engine::SymbolId symbol = 0; symbol < 8; symbol += 2) {
+        on_second += engine.shard_of(symbol) == 1 ? 1 : 0;
+    }
+    assert(on_second == 2);
+    
+    // Every order is still there, wherever its symbol went.
+    for (const ShardedEngine::OrderHandle& handle : resting) {
+        assert(engine.submit_cancel(*producer, handle));
+    }
+    const std::vector<Event> events = drain(engine);
+    assert(of_type(events, EventType::CancelAck).size() == resting.size());
+    
+    // Loads count on whichever shard applied the commands, and add up.
+    for (lob::engine::SymbolId symbol = 0; symbol < 8; symbol += 2) {
+        assert(engine.symbol_load(symbol) == 100);
+    }
+    assert(engine.rebalance() == 0);
+}
+
+void test_engine_lanes_for_late_producers() {
+    // A producer registered after add_shard() gets a lane on every shard,
+    // built by that shard's worker; after stop() there is no worker left.
+    ShardedEngine engine(1, 64, false);
+    auto early = engine.register_producer();
+    assert(engine.add_shard());
+    assert(engine.migrate(1, 1));
+    auto late = engine.register_producer();
+    assert(early && late);
+    for (lob::engine::SymbolId symbol = 0; symbol < 2; ++symbol) {
+        assert(engine.submit_add(*early, symbol, 10000, 1, Side::BUY));
+        assert(engine.submit_add(*late, symbol, 9990, 1, Side::BUY));
+        assert(engine.submitted(*late, engine.shard_of(symbol)) == 1);
+    }
+    const std::vector<Event> events = drain(engine);
+    assert(of_type(events, EventType::Ack).size() == 4);
+    
+    engine.stop();
+    auto after = engine.register_producer();
+    assert(after);
+    assert(!engine.submit_add(*after, 0, 10000, 1, Side::BUY));
+}
+
+void test_parse_cpu_list() {
+    using lob::engine::parse_cpu_list;
+    assert((parse_cpu_list("0-3,8,10-11\n") == std::vector<std::size_t>{0, 1, 2, 3, 8, 10, 11}));
+    assert((parse_cpu_list("5") == std::vector<std::size_t>{5}));
+    assert((parse_cpu_list("2-2") == std::vector<std::size_t>{2}));
+    assert(parse_cpu_list("").empty());
+    assert(parse_cpu_list("\n").empty());
+    
+    // Malformed lists give nothing rather than a partial answer.
+    assert(parse_cpu_list("3-1").empty());
+    assert(parse_cpu_list("1-").empty());
+    assert(parse_cpu_list("0,,2").empty());
+    assert(parse_cpu_list("0 2").empty());
+    assert(parse_cpu_list("cpu0").empty());
+}
+
+namespace {
+
+// Two nodes of two cores, two hardware threads each: cpu N and N + 4 are
+// siblings, cpus 0, 1 (and 4, 5) on node 0, the rest on node 1.
+lob::engine::CpuTopology smt_topology() {
+    lob::engine::CpuTopology topology;
+    for (std::size_t cpu = 0; cpu < 8; ++cpu) {
+        const std::size_t core = cpu % 4;
+        topology.cpus.push_back(lob::engine::CpuInfo{cpu, core, 0, core / 2, true, false});
+    }
+    return topology;
+}
+
+}  // namespace
+
+void test_plan_worker_cpus() {
+    using lob::engine::plan_worker_cpus;
+    using Plan = std::vector<std::size_t>;
+    lob::engine::CpuTopology topology = smt_topology();
+    
+    // One thread per core first, SMT siblings after.
+    assert((plan_worker_cpus(topology, 8) == Plan{0, 1, 2, 3, 4, 5, 6, 7}));
+    
+    // The avoided core goes (sibling included), its node comes first, and
+    // the plan wraps once it runs out.
+    assert((plan_worker_cpus(topology, 8, 2) == Plan{3, 0, 1, 7, 4, 5, 3, 0}));
+    
+    // CPUs outside the affinity mask are skipped.
+    topology.cpus[1].allowed = false;
+    topology.cpus[5].allowed = false;
+    assert((plan_worker_cpus(topology, 4) == Plan{0, 2, 3, 4}));
+    
+    // Allowed isolated CPUs win over the rest.
+    topology = smt_topology();
+    for (std::size_t cpu = 5; cpu < 8; ++cpu) {
+        topology.cpus[cpu].isolated = true;
+    }
+    assert((plan_worker_cpus(topology, 4) == Plan{5, 6, 7, 5}));
+    
+    // Isolated CPUs outside the mask (a cpuset that excludes them) are not
+    // used, even where some are allowed; with none allowed the plan falls
+    // back to the mask.
+    topology.cpus[5].allowed = false;
+    assert((plan_worker_cpus(topology, 3) == Plan{6, 7, 6}));
+    topology.cpus[6].allowed = false;
+    topology.cpus[7].allowed = false;
+    assert((plan_worker_cpus(topology, 5) == Plan{0, 1, 2, 3, 4}));
+    
+    // A single core is used even if it is the one to avoid.
+    lob::engine::CpuTopology single;
+    single.cpus.push_back(lob::engine::CpuInfo{0, 0, 0, 0, true, false});
+    single.cpus.push_back(lob::engine::CpuInfo{4, 0, 0, 0, true, false});
+    assert((plan_worker_cpus(single, 3, 0) == Plan{0, 4, 0}));
+    
+    assert(plan_worker_cpus(lob::engine::CpuTopology{}, 4).empty());
+}
+
+void run_engine_tests() {
+    std::cout << "[Engine Tests]\n";
+    RUN_TEST(test_engine_symbols_do_not_trade);
+    RUN_TEST(test_engine_rejects_foreign_handle);
+    RUN_TEST(test_engine_rejects_unknown_orders);
+    RUN_TEST(test_engine_modify_below_filled_removes_order);
+    RUN_TEST(test_engine_event_contents);
+    RUN_TEST(test_engine_drops_events_past_backlog);
+    RUN_TEST(test_engine_flush_with_producers);
+    RUN_TEST(test_engine_producer_order_preserved);
+    RUN_TEST(test_engine_park_wakes_on_submit);
+    RUN_TEST(test_engine_orders_survive_migration);
+    RUN_TEST(test_engine_commands_during_migration);
+    RUN_TEST(test_engine_rebalance_moves_hot_buckets);
+    RUN_TEST(test_engine_lanes_for_late_producers);
+    RUN_TEST(test_parse_cpu_list);
+    RUN_TEST(test_plan_worker_cpus);
+    std::cout << "\n";
+}
@@ -0,0 +1,22 @@
+#ifndef ENGINE_TESTS_HPP
+#define ENGINE_TESTS_HPP
+
+void test_engine_symbols_do_not_trade();
+void test_engine_rejects_foreign_handle();
+void test_engine_rejects_unknown_orders();
+void test_engine_modify_below_filled_removes_order();
+void test_engine_event_contents();
+void test_engine_drops_events_past_backlog();
+void test_engine_flush_with_producers();
+void test_engine_producer_order_preserved();
+void test_engine_park_wakes_on_submit();
+void test_engine_orders_survive_migration();
+void test_engine_commands_during_migration();
+void test_engine_rebalance_moves_hot_buckets();
+void test_engine_lanes_for_late_producers();
+void test_parse_cpu_list();
+void test_plan_worker_cpus();
+
+void run_engine_tests();
+
+#endif
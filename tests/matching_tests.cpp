@@ -2,6 +2,7 @@
 #include "test_framework.hpp"
 #include <lob/order_book.hpp>
 #include <cassert>
+#include <vector>
 
 using namespace lob;
 
@@ -106,6 +107,322 @@ void test_no_cross_when_price_doesnt_match() {
     assert(book.get_total_orders() == 2);
 }
 
+void test_fill_sink_receives_fills() {
+    OrderBook book;
+    
+    auto r1 = book.add_order(10100, 50, Side::SELL);
+    auto r2 = book.add_order(10200, 50, Side::SELL);
+    
+    Fill fills[4];
+    std::size_t n = 0;
+    auto summary = book.add_order(10200, 80, Side::BUY, [&](const Fill& fill) { fills[n++] = fill; });
+    
+    assert(summary.fill_count == 2);
+    assert(n == 2);
+    assert(!summary.truncated);
+    assert(summary.remaining_quantity == 0);
+    assert(fills[0].sell_order_id == r1.order_id);
+    assert(fills[0].buy_order_id == summary.order_id);
+    assert(fills[0].quantity == 50);
+    assert(fills[1].sell_order_id == r2.order_id);
+    assert(fills[1].price == 10200);
+    assert(fills[1].quantity == 30);
+    assert(book.get_ask_quantity_at_top() == 20);
+}
+
+void test_fill_span_truncates_sweep() {
+    OrderBook book;
+    
+    (void)book.add_order(10100, 10, Side::SELL);
+    (void)book.add_order(10200, 10, Side::SELL);
+    (void)book.add_order(10300, 10, Side::SELL);
+    
+    Fill fills[2];
+    auto summary = book.add_order(10300, 100, Side::BUY, fills, 2);
+    
+    assert(summary.fill_count == 2);
+    assert(summary.truncated);
+    assert(summary.remaining_quantity == 80);
+    assert(fills[1].price == 10200);
+    assert(book.get_total_orders() == 1);       // residual is not rested
+    assert(!book.get_best_bid().has_value());
+    assert(*book.get_best_ask() == 10300);
+    
+    // Enough capacity: behaves like a normal limit order.
+    Fill more[4];
+    auto rested = book.add_order(10300, 30, Side::BUY, more, 4);
+    assert(rested.fill_count == 1);
+    assert(!rested.truncated);
+    assert(rested.remaining_quantity == 20);
+    assert(*book.get_best_bid() == 10300);
+}
+
+void test_market_and_ioc_never_rest() {
+    OrderBook book;
+    
+    (void)book.add_order(10100, 50, Side::SELL);
+    (void)book.add_order(10500, 50, Side::SELL);
+    (void)book.add_order(9900, 50, Side::BUY);
+    
+    // IOC stops at its limit and drops the residual.
+    auto ioc = book.add_order<OrderType::IOC>(10200, 80, Side::BUY);
+    assert(ioc.order_id != 0);
+    assert(ioc.fills.size() == 1);
+    assert(ioc.remaining_quantity == 30);
+    assert(ioc.handle.generation == 0);
+    assert(*book.get_best_bid() == 9900);
+    assert(book.get_total_orders() == 2);
+    
+    // Market sweeps regardless of price and never rests either.
+    auto market = book.add_order<OrderType::MARKET>(0, 80, Side::BUY);
+    assert(market.fills.size() == 1);
+    assert(market.fills[0].price == 10500);
+    assert(market.remaining_quantity == 30);
+    assert(!book.get_best_ask().has_value());
+    assert(book.get_total_orders() == 1);
+    
+    // Nothing to match: no fills, nothing rested.
+    auto empty = book.add_order<OrderType::MARKET>(0, 10, Side::BUY);
+    assert(empty.fills.empty());
+    assert(empty.remaining_quantity == 10);
+    assert(book.get_total_orders() == 1);
+}
+
+void test_fok_fills_completely_or_not_at_all() {
+    OrderBook book;
+    
+    (void)book.add_order(10100, 30, Side::SELL);
+    (void)book.add_order(10100, 30, Side::SELL);
+    (void)book.add_order(10200, 30, Side::SELL);
+    
+    // 90 available but only 60 within the limit: killed, book untouched.
+    auto killed = book.add_order<OrderType::FOK>(10100, 70, Side::BUY);
+    assert(killed.order_id == 0);
+    assert(killed.fills.empty());
+    assert(book.get_total_orders() == 3);
+    assert(book.get_ask_quantity_at_top() == 60);
+    
+    // Would fit in volume but not in a two-slot fill buffer.
+    Fill fills[2];
+    auto no_room = book.add_order<OrderType::FOK>(10200, 70, Side::BUY, fills, 2);
+    assert(no_room.order_id == 0);
+    assert(book.get_total_orders() == 3);
+    
+    auto filled = book.add_order<OrderType::FOK>(10200, 70, Side::BUY);
+    assert(filled.fills.size() == 3);
+    assert(filled.remaining_quantity == 0);
+    assert(*book.get_best_ask() == 10200);
+    assert(book.get_ask_quantity_at_top() == 20);
+}
+
+void test_post_only_reject_and_slide() {
+    OrderBook book;
+    
+    (void)book.add_order(10000, 50, Side::BUY);
+    (void)book.add_order(10100, 50, Side::SELL);
+    
+    auto rejected = book.add_order<OrderType::POST_ONLY>(10100, 10, Side::BUY);
+    assert(rejected.order_id == 0);
+    assert(rejected.fills.empty());
+    assert(book.get_ask_quantity_at_top() == 50);
+    
+    auto passive = book.add_order<OrderType::POST_ONLY>(10050, 10, Side::BUY);
+    assert(passive.order_id != 0);
+    assert(*book.get_best_bid() == 10050);
+    
+    // Slides to one tick behind the opposite best instead of crossing.
+    auto slid = book.add_order<OrderType::POST_ONLY_SLIDE>(9000, 10, Side::SELL);
+    assert(slid.order_id != 0);
+    assert(slid.fills.empty());
+    assert(*book.get_best_ask() == 10051);
+    assert(book.cancel_order(slid.order_id));
+    assert(*book.get_best_ask() == 10100);
+}
+
+void test_replace_order_priority_rules() {
+    OrderBook book;
+    
+    auto first = book.add_order(10000, 100, Side::BUY);
+    auto second = book.add_order(10000, 100, Side::BUY);
+    
+    // Shrinking at the same price keeps the front of the queue.
+    auto shrunk = book.replace_order(first.order_id, 10000, 60);
+    assert(shrunk.order_id == first.order_id);
+    assert(shrunk.remaining_quantity == 60);
+    assert(shrunk.handle.slot == first.handle.slot);
+    auto hit = book.add_order(10000, 10, Side::SELL);
+    assert(hit.fills[0].buy_order_id == first.order_id);
+    
+    // Growing loses priority to the order behind it.
+    auto grown = book.replace_order(first.order_id, 10000, 200);
+    assert(grown.remaining_quantity == 190);
+    hit = book.add_order(10000, 10, Side::SELL);
+    assert(hit.fills[0].buy_order_id == second.order_id);
+    
+    // A price change moves the order and keeps its handle valid.
+    auto moved = book.replace_order(first.order_id, 9900, 200);
+    assert(moved.handle.slot == first.handle.slot);
+    assert(moved.handle.generation == first.handle.generation);
+    assert(book.get_bid_levels() == 2);
+    assert(book.cancel_order(first.handle));
+    assert(book.get_total_orders() == 1);
+}
+
+void test_replace_order_crossing_and_cancel() {
+    OrderBook book;
+    
+    (void)book.add_order(10100, 30, Side::SELL);
+    auto bid = book.add_order(10000, 50, Side::BUY);
+    
+    // Re-pricing through the ask matches before resting the remainder.
+    auto crossed = book.replace_order(bid.order_id, 10100, 50);
+    assert(crossed.fills.size() == 1);
+    assert(crossed.fills[0].price == 10100);
+    assert(crossed.fills[0].quantity == 30);
+    assert(crossed.remaining_quantity == 20);
+    assert(*book.get_best_bid() == 10100);
+    assert(!book.get_best_ask().has_value());
+    
+    // Total at or below the filled quantity cancels.
+    auto gone = book.replace_order(bid.order_id, 10100, 30);
+    assert(gone.order_id == bid.order_id);
+    assert(gone.remaining_quantity == 0);
+    assert(book.get_total_orders() == 0);
+    
+    // Unknown ids and off-book prices leave the book untouched.
+    auto rest = book.add_order(10000, 10, Side::BUY);
+    assert(book.replace_order(rest.order_id + 1, 10000, 5).order_id == 0);
+    OrderBook penny(100);
+    auto on_tick = penny.add_order(10000, 10, Side::BUY);
+    assert(penny.replace_order(on_tick.order_id, 10050, 10).order_id == 0);
+    assert(*penny.get_best_bid() == 10000);
+}
+
+namespace {
+
+struct RecordingSink {
+    std::vector<Fill> fills;
+    std::vector<OrderBook::AddSummary> results;
+
+    void on_fill(const Fill& fill) { fills.push_back(fill); }
+    void on_result(std::size_t index, const OrderBook::AddSummary& result) {
+        assert(index == results.size());
+        results.push_back(result);
+    }
+};
+
+}  // namespace
+
+void test_apply_batch_matches_single_calls() {
+    // Ids are issued from 1, so later commands can refer to adds made
+    // earlier in the same batch.
+    const std::vector<BookCommand> commands = {
+        {BookAction::ADD, Side::BUY, OrderType::LIMIT, 0, 10000, 100},     // id 1
+        {BookAction::ADD, Side::BUY, OrderType::LIMIT, 0, 9900, 50},       // id 2
+        {BookAction::ADD, Side::SELL, OrderType::LIMIT, 0, 10100, 80},     // id 3
+        {BookAction::MODIFY, Side::BUY, OrderType::LIMIT, 1, 0, 60},
+        {BookAction::ADD, Side::SELL, OrderType::IOC, 0, 9900, 70},        // id 4
+        {BookAction::CANCEL, Side::BUY, OrderType::LIMIT, 2, 0, 0},
+        {BookAction::CANCEL, Side::BUY, OrderType::LIMIT, 2, 0, 0},
+        {BookAction::REPLACE, Side::SELL, OrderType::LIMIT, 3, 10050, 90},
+        {BookAction::ADD, Side::BUY, OrderType::POST_ONLY, 0, 10050, 10},  // id 5, rejected
+        {BookAction::ADD, Side::BUY, OrderType::LIMIT, 0, 10060, 40},      // id 6
+    };
+
+    OrderBook batched;
+    RecordingSink sink;
+    batched.apply_batch(commands.data(), commands.size(), sink);
+    assert(sink.results.size() == commands.size());
+
+    OrderBook single;
+    std::vector<Fill> fills;
+    auto collect = [&fills](const Fill& fill) { fills.push_back(fill); };
+    (void)single.add_order(10000, 100, Side::BUY, collect);
+    (void)single.add_order(9900, 50, Side::BUY, collect);
+    (void)single.add_order(10100, 80, Side::SELL, collect);
+    assert(single.modify_order(1, 60));
+    (void)single.add_order<OrderType::IOC>(9900, 70, Side::SELL, collect);
+    assert(single.cancel_order(2));
+    assert(!single.cancel_order(2));
+    (void)single.replace_order(3, 10050, 90, collect);
+    (void)single.add_order<OrderType::POST_ONLY>(10050, 10, Side::BUY, collect);
+    (void)single.add_order(10060, 40, Side::BUY, collect);
+
+    assert(sink.fills.size() == fills.size());
+    for (std::size_t i = 0; i < fills.size(); ++i) {
+        assert(sink.fills[i].buy_order_id == fills[i].buy_order_id);
+        assert(sink.fills[i].sell_order_id == fills[i].sell_order_id);
+        assert(sink.fills[i].price == fills[i].price);
+        assert(sink.fills[i].quantity == fills[i].quantity);
+    }
+    assert(sink.results[3].remaining_quantity == 60);
+    assert(sink.results[4].fill_count == 2);            // IOC sweeps id 1 into id 2
+    assert(sink.results[5].order_id == 2);
+    assert(sink.results[6].order_id == 0);
+    assert(sink.results[8].order_id == 0);
+    assert(sink.results[9].fill_count == 1);
+
+    assert(batched.get_best_bid() == single.get_best_bid());
+    assert(batched.get_best_ask() == single.get_best_ask());
+    assert(batched.get_total_orders() == single.get_total_orders());
+    assert(batched.get_ask_quantity_at_top() == 50);
+}
+
+namespace {
+
+struct CompactPolicy : DefaultBookPolicy {
+    static constexpr bool kCompactOrders = true;
+};
+
+// The batch pipeline looks orders up a few commands ahead; by the time they
+// run, earlier commands may have cancelled, recycled or replaced them.
+template <typename Book>
+void check_batch_with_stale_lookups() {
+    Book book;
+    (void)book.add_order(10000, 10, Side::BUY);   // id 1
+    (void)book.add_order(9990, 10, Side::BUY);    // id 2
+    (void)book.add_order(10100, 10, Side::SELL);  // id 3
+
+    const std::vector<typename Book::command_type> commands = {
+        {BookAction::CANCEL, Side::BUY, OrderType::LIMIT, 1, 0, 0},
+        {BookAction::ADD, Side::BUY, OrderType::LIMIT, 0, 9980, 5},        // id 4, in id 1's slot
+        {BookAction::MODIFY, Side::BUY, OrderType::LIMIT, 1, 0, 20},       // gone, not id 4
+        {BookAction::REPLACE, Side::BUY, OrderType::LIMIT, 2, 9995, 10},
+        {BookAction::MODIFY, Side::BUY, OrderType::LIMIT, 2, 0, 4},
+        {BookAction::ADD, Side::SELL, OrderType::IOC, 0, 9990, 3},         // id 5
+        {BookAction::CANCEL, Side::BUY, OrderType::LIMIT, 2, 0, 0},
+        {BookAction::CANCEL, Side::BUY, OrderType::LIMIT, 4, 0, 0},
+        {BookAction::CANCEL, Side::BUY, OrderType::LIMIT, 4, 0, 0},
+    };
+
+    struct Sink {
+        std::vector<typename Book::AddSummary> results;
+        void on_fill(const typename Book::fill_type&) {}
+        void on_result(std::size_t, const typename Book::AddSummary& result) { results.push_back(result); }
+    } sink;
+    book.apply_batch(commands.data(), commands.size(), sink);
+
+    assert(sink.results.size() == commands.size());
+    assert(sink.results[0].order_id == 1);
+    assert(sink.results[1].order_id == 4);
+    assert(sink.results[2].order_id == 0);
+    assert(sink.results[3].order_id == 2);
+    assert(sink.results[4].order_id == 2 && sink.results[4].remaining_quantity == 4);
+    assert(sink.results[5].fill_count == 1);
+    assert(sink.results[6].order_id == 2);
+    assert(sink.results[7].order_id == 4);
+    assert(sink.results[8].order_id == 0);
+    assert(!book.get_best_bid().has_value());
+    assert(book.get_total_orders() == 1);
+}
+
+}  // namespace
+
+void test_apply_batch_rechecks_lookups() {
+    check_batch_with_stale_lookups<OrderBook>();
+    check_batch_with_stale_lookups<BasicOrderBook<CompactPolicy>>();
+}
+
 void run_matching_tests() {
     std::cout << "[Matching Tests]\n";
     RUN_TEST(test_aggressive_buy_matches_asks);
@@ -115,5 +432,14 @@ void run_matching_tests() {
     RUN_TEST(test_fifo_matching_order);
     RUN_TEST(test_price_priority);
     RUN_TEST(test_no_cross_when_price_doesnt_match);
+    RUN_TEST(test_fill_sink_receives_fills);
+    RUN_TEST(test_fill_span_truncates_sweep);
+    RUN_TEST(test_market_and_ioc_never_rest);
+    RUN_TEST(test_fok_fills_completely_or_not_at_all);
+    RUN_TEST(test_post_only_reject_and_slide);
+    RUN_TEST(test_replace_order_priority_rules);
+    RUN_TEST(test_replace_order_crossing_and_cancel);
+    RUN_TEST(test_apply_batch_matches_single_calls);
+    RUN_TEST(test_apply_batch_rechecks_lookups);
     std::cout << "\n";
 }
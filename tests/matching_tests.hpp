@@ -8,6 +8,15 @@ void test_sweep_multiple_price_levels();
 void test_fifo_matching_order();
 void test_price_priority();
 void test_no_cross_when_price_doesnt_match();
+void test_fill_sink_receives_fills();
+void test_fill_span_truncates_sweep();
+void test_market_and_ioc_never_rest();
+void test_fok_fills_completely_or_not_at_all();
+void test_post_only_reject_and_slide();
+void test_replace_order_priority_rules();
+void test_replace_order_crossing_and_cancel();
+void test_apply_batch_matches_single_calls();
+void test_apply_batch_rechecks_lookups();
 
 void run_matching_tests();
 
@@ -1,7 +1,10 @@
 #include "order_tests.hpp"
 #include "test_framework.hpp"
+#include <lob/book_registry.hpp>
 #include <lob/order_book.hpp>
 #include <cassert>
+#include <memory>
+#include <vector>
 
 using namespace lob;
 
@@ -87,6 +90,372 @@ void test_modify_nonexistent_order() {
     assert(!modified);
 }
 
+void test_cancel_churn_keeps_index_consistent() {
+    OrderBook book;
+    std::vector<OrderId> live;
+    
+    // Interleave adds and cancels past the initial pool size so long probe
+    // chains and backward-shift deletion are exercised.
+    for (int i = 0; i < 200000; ++i) {
+        auto r = book.add_order(9000 + (i % 500), 10, Side::BUY);
+        live.push_back(r.order_id);
+        if (i % 3 != 0) {
+            const std::size_t victim = static_cast<std::size_t>(i * 7919) % live.size();
+            assert(book.cancel_order(live[victim]));
+            assert(!book.cancel_order(live[victim]));
+            live[victim] = live.back();
+            live.pop_back();
+        }
+    }
+    
+    assert(book.get_total_orders() == live.size());
+    for (OrderId id : live) {
+        assert(book.modify_order(id, 5));
+    }
+    for (OrderId id : live) {
+        assert(book.cancel_order(id));
+    }
+    assert(book.get_total_orders() == 0);
+    assert(book.get_bid_levels() == 0);
+}
+
+void test_cancel_and_modify_by_handle() {
+    OrderBook book;
+    
+    auto r1 = book.add_order(10000, 50, Side::BUY);
+    auto r2 = book.add_order(10000, 30, Side::BUY);
+    
+    assert(book.modify_order(r2.handle, 10));
+    assert(book.get_bid_quantity_at_top() == 60);
+    
+    assert(book.cancel_order(r1.handle));
+    assert(book.get_total_orders() == 1);
+    assert(book.get_bid_quantity_at_top() == 10);
+    assert(!book.cancel_order(r1.order_id));    // handle cancel also drops the id entry
+}
+
+void test_stale_handle_rejected() {
+    OrderBook book;
+    
+    auto resting = book.add_order(10000, 50, Side::BUY);
+    assert(book.cancel_order(resting.order_id));
+    assert(!book.cancel_order(resting.handle));
+    assert(!book.modify_order(resting.handle, 10));
+    
+    // The freed slot is recycled; the old handle must not reach the new order.
+    auto reused = book.add_order(10000, 40, Side::BUY);
+    assert(reused.handle.slot == resting.handle.slot);
+    assert(reused.handle.generation != resting.handle.generation);
+    assert(!book.cancel_order(resting.handle));
+    assert(book.get_bid_quantity_at_top() == 40);
+    
+    // Filled orders invalidate their handles as well.
+    (void)book.add_order(10000, 40, Side::SELL);
+    assert(!book.cancel_order(reused.handle));
+    
+    // Fully filled aggressors never rest and get no handle.
+    auto ask = book.add_order(10100, 10, Side::SELL);
+    auto taker = book.add_order(10100, 10, Side::BUY);
+    assert(taker.handle.generation == 0);
+    assert(!book.cancel_order(ask.handle));
+    assert(!book.cancel_order(OrderHandle{0, 0}));
+    assert(!book.cancel_order(OrderHandle{1u << 30, 1}));
+}
+
+void test_handle_only_orders() {
+    OrderBook book;
+    Fill fills[4];
+    
+    auto bid = book.add_order_handle(10000, 50, Side::BUY, fills, 4);
+    auto ask = book.add_order_handle(10100, 50, Side::SELL, fills, 4);
+    assert(book.get_total_orders() == 2);
+    assert(!book.cancel_order(bid.order_id));   // not reachable by id
+    
+    assert(book.modify_order(bid.handle, 20));
+    assert(book.get_bid_quantity_at_top() == 20);
+    
+    auto taker = book.add_order(10100, 20, Side::BUY);
+    assert(taker.fills.size() == 1);
+    assert(taker.fills[0].sell_order_id == ask.order_id);
+    assert(book.get_total_orders() == 2);
+    
+    assert(book.cancel_order(bid.handle));
+    assert(!book.cancel_order(bid.handle));
+    assert(book.get_total_orders() == 1);
+    
+    (void)book.add_order(10100, 30, Side::BUY);     // fills the rest of the ask
+    assert(!book.cancel_order(ask.handle));
+    assert(book.get_total_orders() == 0);
+}
+
+void test_banded_policy_book() {
+    using BandedBook = BasicOrderBook<BandedBookPolicy<9000, 11000>>;
+    static_assert(sizeof(BandedBook::order_type) < sizeof(Order), "narrow types should shrink Order");
+    static_assert(BandedBook::kSingleWindow, "band should fit in one window");
+    static_assert(!OrderBook::kSingleWindow, "unbounded band needs the overflow store");
+    
+    BandedBook book;
+    
+    auto bid = book.add_order(10000, 50, Side::BUY);
+    (void)book.add_order(9000, 10, Side::BUY);
+    (void)book.add_order(11000, 10, Side::SELL);
+    assert(book.get_total_orders() == 3);
+    
+    // Outside the band: rejected before allocating an id or an order.
+    auto low = book.add_order(8999, 10, Side::BUY);
+    auto high = book.add_order(11001, 10, Side::SELL);
+    assert(low.order_id == 0);
+    assert(high.order_id == 0);
+    assert(book.get_total_orders() == 3);
+    
+    auto taker = book.add_order(9000, 55, Side::SELL);
+    assert(taker.fills.size() == 2);
+    assert(taker.fills[0].buy_order_id == bid.order_id);
+    assert(taker.fills[0].price == 10000);
+    assert(taker.fills[1].price == 9000);
+    assert(*book.get_best_bid() == 9000);
+    assert(book.get_bid_quantity_at_top() == 5);
+}
+
+namespace {
+
+struct CompactPolicy : DefaultBookPolicy {
+    static constexpr std::size_t kWindowTicks = 64;
+    static constexpr bool kCompactOrders = true;
+};
+
+using CompactBook = BasicOrderBook<CompactPolicy>;
+
+}  // namespace
+
+void test_compact_order_storage() {
+    static_assert(sizeof(CompactBook::order_type) * 2 <= sizeof(Order), "hot record should halve Order");
+    
+    CompactBook book;
+    
+    auto first = book.add_order(10000, 100, Side::BUY);
+    auto second = book.add_order(10000, 50, Side::BUY);
+    auto far = book.add_order_handle(9000, 70, Side::BUY, nullptr, 0);   // overflow level
+    (void)book.add_order(10010, 20, Side::SELL);
+    assert(book.get_total_orders() == 4);
+    
+    // Links, ids and the level found from price all line up on the match path.
+    auto taker = book.add_order(10000, 120, Side::SELL);
+    assert(taker.fills.size() == 2);
+    assert(taker.fills[0].buy_order_id == first.order_id);
+    assert(taker.fills[1].buy_order_id == second.order_id);
+    assert(taker.fills[1].quantity == 20);
+    
+    // Partially filled: modify counts the filled part, as with pooled orders.
+    assert(book.modify_order(second.order_id, 40));
+    assert(book.get_bid_quantity_at_top() == 20);
+    assert(book.modify_order(far.handle, 10));
+    assert(book.cancel_order(second.order_id));
+    assert(*book.get_best_bid() == 9000);
+    assert(book.get_bid_quantity_at_top() == 10);
+    
+    // Slots are recycled with a new generation.
+    assert(book.cancel_order(far.handle));
+    assert(!book.cancel_order(far.handle));
+    auto again = book.add_order_handle(9000, 5, Side::BUY, nullptr, 0);
+    assert(again.handle.slot == far.handle.slot);
+    assert(again.handle.generation != far.handle.generation);
+    assert(book.get_total_orders() == 2);
+}
+
+void test_book_registry_shares_arena() {
+    BookRegistry registry(1024, 64);
+    assert(registry.find(7) == nullptr);
+    
+    // Books are created on first use and looked up densely by symbol.
+    auto& first = registry.book(7);
+    auto& second = registry.book(3);
+    assert(registry.book_count() == 2);
+    assert(&registry.book(7) == &first);
+    
+    // Orders and overflow levels of both books come from the one arena.
+    auto bid = first.add_order(10000, 100, Side::BUY);
+    auto ask = second.add_order(20000, 50, Side::SELL);
+    (void)first.add_order(100, 10, Side::BUY);      // outside the window
+    assert(registry.arena().orders.capacity() == 4096);
+    assert(first.get_bid_levels() == 2);
+    auto taker = first.add_order(10000, 40, Side::SELL);
+    assert(taker.fills.size() == 1);
+    assert(taker.fills[0].buy_order_id == bid.order_id);
+    assert(second.get_total_orders() == 1);
+    
+    // A quiet symbol costs kilobytes; a burst grows only its own index.
+    assert(second.memory_usage() < 64 * 1024);
+    std::vector<OrderId> burst;
+    for (int i = 0; i < 1000; ++i) {
+        burst.push_back(first.add_order(9990, 1, Side::BUY).order_id);
+    }
+    for (OrderId id : burst) {
+        assert(first.cancel_order(id));
+    }
+    const std::size_t after_burst = first.memory_usage();
+    assert(after_burst > second.memory_usage() + 16 * 1024);
+    
+    // Idle books are shrunk, or released once empty.
+    assert(second.cancel_order(ask.order_id));
+    assert(registry.trim() == 0);
+    assert(registry.trim() == 1);
+    assert(registry.find(3) == nullptr);
+    assert(registry.find(7) == &first);
+    assert(first.memory_usage() < after_burst);
+    assert(first.get_total_orders() == 2);
+    assert(registry.book(3).get_total_orders() == 0);
+    assert(registry.book_count() == 2);
+    
+    // release() drops a book with its resting orders.
+    assert(registry.release(7));
+    assert(!registry.release(7));
+    assert(registry.find(7) == nullptr);
+    assert(registry.book_count() == 1);
+    assert(registry.book(7).get_total_orders() == 0);
+}
+
+namespace {
+
+struct PagedPolicy : DefaultBookPolicy {
+    static constexpr PageOptions kPageOptions{true, false, true};
+};
+
+}  // namespace
+
+void test_page_backed_book() {
+    const PageStats before = page_stats();
+    {
+        auto book = std::make_unique<BasicOrderBook<PagedPolicy>>();
+        const PageStats during = page_stats();
+        // Book object and pools are page-mapped; with huge pages requested
+        // every region ends up either huge-backed or counted as a fallback.
+        const std::uint64_t mapped = (during.small_bytes + during.transparent_bytes + during.explicit_bytes) -
+                                     (before.small_bytes + before.transparent_bytes + before.explicit_bytes);
+        assert(mapped >= sizeof(BasicOrderBook<PagedPolicy>));
+        assert(during.transparent_bytes + during.explicit_bytes > before.transparent_bytes + before.explicit_bytes ||
+               during.huge_fallbacks > before.huge_fallbacks);
+        
+        auto bid = book->add_order(10000, 100, Side::BUY);
+        (void)book->add_order(10100, 50, Side::SELL);
+        auto taker = book->add_order(10000, 30, Side::SELL);
+        assert(taker.fills.size() == 1 && taker.fills[0].buy_order_id == bid.order_id);
+        assert(book->cancel_order(bid.order_id));
+        assert(book->get_total_orders() == 1);
+    }
+    
+    // A huge-page pool fills its last huge page with blocks.
+    {
+        ObjectPool<std::uint64_t> pool;
+        pool.set_page_options(PageOptions{true, false, false});
+        pool.reserve(10);
+        assert(pool.memory_usage() == kHugePageSize);
+    }
+    
+    // Regions are returned with their owners.
+    const PageStats after = page_stats();
+    assert(after.small_bytes == before.small_bytes);
+    assert(after.transparent_bytes == before.transparent_bytes);
+    assert(after.explicit_bytes == before.explicit_bytes);
+}
+
+void test_lazy_pool_slots() {
+    ObjectPool<std::uint64_t> pool;
+    pool.reserve(10000);
+    assert(pool.capacity() >= 10000);
+    assert(pool.high_water() == 0);
+    
+    // Fresh slots come off the bump pointer in order; nothing above the
+    // high-water mark resolves, even inside the reserved blocks.
+    std::uint64_t* a = pool.create(1u);
+    std::uint64_t* b = pool.create(2u);
+    assert(ObjectPool<std::uint64_t>::slot_of(a) == 0 && ObjectPool<std::uint64_t>::slot_of(b) == 1);
+    assert(pool.high_water() == 2);
+    assert(pool.resolve(1, 1) == b);
+    assert(pool.resolve(2, 1) == nullptr);
+    
+    // Recycled slots are reused before the high-water mark moves.
+    pool.destroy(a);
+    std::uint64_t* c = pool.create(3u);
+    assert(c == a && *c == 3 && pool.high_water() == 2);
+    assert(pool.resolve(0, 1) == nullptr);
+    pool.prefault();
+    assert(*b == 2 && *c == 3);
+    
+    // A full pool without growth fails only once the bump pointer is spent.
+    ObjectPool<std::uint64_t, 4> fixed;
+    fixed.reserve(4);
+    fixed.set_allow_growth(false);
+    for (std::uint64_t i = 0; i < 4; ++i) {
+        assert(fixed.create(i) != nullptr);
+    }
+    assert(fixed.create(4u) == nullptr && fixed.growth_failures() == 1);
+    
+    // Books reject handles into reserved but never-used slots.
+    OrderBook book;
+    CompactBook compact;
+    book.prefault();
+    (void)book.add_order(10000, 10, Side::BUY);
+    (void)compact.add_order(10000, 10, Side::BUY);
+    assert(!book.cancel_order(OrderHandle{5, 1}));
+    assert(!compact.cancel_order(OrderHandle{5, 1}));
+    assert(book.get_total_orders() == 1 && compact.get_total_orders() == 1);
+}
+
+void test_restore_order_rebuilds_queue() {
+    OrderBook source;
+    auto first = source.add_order(10000, 100, Side::BUY);
+    auto second = source.add_order(10000, 50, Side::BUY);
+    auto deeper = source.add_order(9990, 70, Side::BUY);
+    auto ask = source.add_order(10100, 30, Side::SELL);
+    auto taker = source.add_order(10000, 40, Side::SELL);
+    assert(taker.fills.size() == 1);
+    
+    struct Captured {
+        OrderId id;
+        Side side;
+        Price price;
+        Quantity quantity;
+        Quantity remaining;
+    };
+    std::vector<Captured> orders;
+    source.for_each_order([&](OrderId id, Side side, Price price, Quantity quantity, Quantity remaining) {
+        orders.push_back({id, side, price, quantity, remaining});
+    });
+    assert(orders.size() == 4);
+    assert(orders[0].id == first.order_id && orders[0].remaining == 60 && orders[0].quantity == 100);
+    assert(orders[1].id == second.order_id);
+    assert(orders[2].id == deeper.order_id);
+    assert(orders[3].id == ask.order_id && orders[3].side == Side::SELL);
+    
+    OrderBook target;
+    std::vector<OrderId> restored;
+    for (const Captured& order : orders) {
+        auto result = target.restore_order(order.price, order.quantity, order.remaining, order.side);
+        assert(result.order_id != 0 && result.remaining_quantity == order.remaining);
+        restored.push_back(result.order_id);
+    }
+    assert(target.get_bid_quantity_at(10000) == 110);
+    assert(target.get_ask_quantity_at(10100) == 30);
+    assert(target.get_total_orders() == 4);
+    
+    // Queue order survives: the partly filled order is still first.
+    auto sweep = target.add_order(10000, 70, Side::SELL);
+    assert(sweep.fills.size() == 2);
+    assert(sweep.fills[0].buy_order_id == restored[0] && sweep.fills[0].quantity == 60);
+    assert(sweep.fills[1].buy_order_id == restored[1] && sweep.fills[1].quantity == 10);
+    
+    // The filled amount carries over: total 80 with 60 filled leaves 20.
+    auto partial = target.restore_order(9980, 80, 20, Side::BUY);
+    assert(target.modify_order(partial.order_id, 70));
+    assert(target.get_bid_quantity_at(9980) == 10);
+    
+    // Crossing, empty or over-filled orders are refused.
+    assert(target.restore_order(10100, 10, 10, Side::BUY).order_id == 0);
+    assert(target.restore_order(9000, 10, 0, Side::BUY).order_id == 0);
+    assert(target.restore_order(9000, 10, 11, Side::BUY).order_id == 0);
+}
+
 void run_order_tests() {
     std::cout << "[Order Tests]\n";
     RUN_TEST(test_add_order_to_empty_book);
@@ -96,5 +465,15 @@ void run_order_tests() {
     RUN_TEST(test_cancel_removes_empty_price_level);
     RUN_TEST(test_modify_order);
     RUN_TEST(test_modify_nonexistent_order);
+    RUN_TEST(test_cancel_churn_keeps_index_consistent);
+    RUN_TEST(test_cancel_and_modify_by_handle);
+    RUN_TEST(test_stale_handle_rejected);
+    RUN_TEST(test_handle_only_orders);
+    RUN_TEST(test_compact_order_storage);
+    RUN_TEST(test_banded_policy_book);
+    RUN_TEST(test_book_registry_shares_arena);
+    RUN_TEST(test_page_backed_book);
+    RUN_TEST(test_restore_order_rebuilds_queue);
+    RUN_TEST(test_lazy_pool_slots);
     std::cout << "\n";
 }
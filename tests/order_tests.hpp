@@ -8,6 +8,16 @@ void test_cancel_nonexistent_order();
 void test_cancel_removes_empty_price_level();
 void test_modify_order();
 void test_modify_nonexistent_order();
+void test_cancel_churn_keeps_index_consistent();
+void test_cancel_and_modify_by_handle();
+void test_stale_handle_rejected();
+void test_handle_only_orders();
+void test_compact_order_storage();
+void test_banded_policy_book();
+void test_book_registry_shares_arena();
+void test_page_backed_book();
+void test_restore_order_rebuilds_queue();
+void test_lazy_pool_slots();
 
 void run_order_tests();
 
@@ -1,10 +1,44 @@
 #include "query_tests.hpp"
 #include "test_framework.hpp"
 #include <lob/order_book.hpp>
+#include <lob/protocol/itch.hpp>
 #include <cassert>
+#include <vector>
 
 using namespace lob;
 
+namespace {
+
+struct NarrowWindowPolicy : DefaultBookPolicy {
+    static constexpr std::size_t kWindowTicks = 64;
+};
+
+using NarrowWindowBook = BasicOrderBook<NarrowWindowPolicy>;
+
+struct FixedPennyPolicy : DefaultBookPolicy {
+    static constexpr Price kTickSize = itch::kPennyTick;
+};
+
+struct IndexedNarrowPolicy : NarrowWindowPolicy {
+    static constexpr bool kDepthIndex = true;
+};
+
+using IndexedNarrowBook = BasicOrderBook<IndexedNarrowPolicy>;
+
+struct TopThreePolicy : NarrowWindowPolicy {
+    static constexpr std::size_t kTopLevels = 3;
+};
+
+using TopThreeBook = BasicOrderBook<TopThreePolicy>;
+
+struct TopOnePolicy : NarrowWindowPolicy {
+    static constexpr std::size_t kTopLevels = 1;
+};
+
+using TopOneBook = BasicOrderBook<TopOnePolicy>;
+
+}  // namespace
+
 void test_best_bid_ask() {
     OrderBook book;
     
@@ -58,11 +92,347 @@ void test_snapshot() {
     assert(snapshot.asks[0].quantity == 70);
 }
 
+void test_best_price_across_wide_gaps() {
+    OrderBook book;
+    
+    // Levels scattered across the ladder so the next best is several
+    // bitmap words (and summary words) away.
+    auto far_bid = book.add_order(-99000, 10, Side::BUY);
+    auto mid_bid = book.add_order(-20000, 10, Side::BUY);
+    auto near_bid = book.add_order(9000, 10, Side::BUY);
+    (void)book.add_order(10000, 10, Side::SELL);
+    auto far_ask = book.add_order(99999, 10, Side::SELL);
+    
+    assert(book.get_bid_levels() == 3);
+    assert(book.get_ask_levels() == 2);
+    
+    assert(book.cancel_order(near_bid.order_id));
+    assert(*book.get_best_bid() == -20000);
+    assert(book.cancel_order(mid_bid.order_id));
+    assert(*book.get_best_bid() == -99000);
+    
+    // Sweeping the only near ask must find the far one.
+    auto taker = book.add_order(10000, 10, Side::BUY);
+    assert(taker.fills.size() == 1);
+    assert(*book.get_best_ask() == 99999);
+    assert(book.get_ask_levels() == 1);
+    
+    assert(book.cancel_order(far_ask.order_id));
+    assert(!book.get_best_ask().has_value());
+    assert(book.cancel_order(far_bid.order_id));
+    assert(!book.get_best_bid().has_value());
+    assert(book.get_bid_levels() == 0);
+}
+
+void test_window_recenters_as_market_drifts() {
+    NarrowWindowBook book;
+    
+    // Walk the market far beyond the initial window; each step rests a
+    // bid/ask pair around the new mid and keeps the old levels alive.
+    for (Price mid = 0; mid <= 1000; mid += 20) {
+        (void)book.add_order(mid - 1, 10, Side::BUY);
+        (void)book.add_order(mid + 1, 10, Side::SELL);
+        auto taker = book.add_order(mid + 1, 10, Side::BUY);
+        assert(taker.fills.size() == 1);
+    }
+    
+    assert(*book.get_best_bid() == 999);
+    assert(!book.get_best_ask().has_value());
+    assert(book.get_bid_levels() == 51);
+    
+    // Stale levels behind the market are still reachable in price order.
+    auto snapshot = book.get_snapshot(100);
+    assert(snapshot.bids.size() == 51);
+    assert(snapshot.bids[0].price == 999);
+    assert(snapshot.bids[1].price == 979);
+    assert(snapshot.bids[50].price == -1);
+    
+    // Selling through the whole book pulls levels back out of overflow.
+    auto sweep = book.add_order(-1, 1000, Side::SELL);
+    assert(sweep.fills.size() == 51);
+    assert(sweep.fills.back().price == -1);
+    assert(!book.get_best_bid().has_value());
+    assert(book.get_total_orders() == 1);
+}
+
+void test_far_orders_kept_outside_window() {
+    NarrowWindowBook book;
+    
+    (void)book.add_order(1000, 10, Side::BUY);
+    (void)book.add_order(1002, 10, Side::SELL);
+    
+    // Far-from-market orders rest without moving the window.
+    auto stink_bid = book.add_order(1, 10, Side::BUY);
+    auto far_ask = book.add_order(1000000, 10, Side::SELL);
+    assert(stink_bid.handle.generation != 0);
+    assert(far_ask.handle.generation != 0);
+    (void)book.add_order(999, 10, Side::BUY);
+    (void)book.add_order(1003, 10, Side::SELL);
+    
+    auto snapshot = book.get_snapshot(5);
+    assert(snapshot.bids.size() == 3);
+    assert(snapshot.bids[1].price == 999);
+    assert(snapshot.bids[2].price == 1);
+    assert(snapshot.asks.size() == 3);
+    assert(snapshot.asks[1].price == 1003);
+    assert(snapshot.asks[2].price == 1000000);
+    assert(book.get_bid_quantity_at(1) == 10);
+    assert(book.get_ask_quantity_at(1003) == 10);
+    assert(book.get_bid_quantity_at(998) == 0);
+    assert(book.get_ask_quantity_at(1000) == 0);
+    
+    assert(book.cancel_order(stink_bid.order_id));
+    assert(book.cancel_order(far_ask.order_id));
+    assert(book.get_bid_levels() == 2);
+    assert(book.get_ask_levels() == 2);
+}
+
+void test_best_level_survives_eviction() {
+    NarrowWindowBook book;
+    
+    // The window starts on the first bid; the far ask rests in overflow.
+    auto first = book.add_order(-40, 10, Side::BUY);
+    auto second = book.add_order(-40, 15, Side::BUY);
+    (void)book.add_order(40, 10, Side::SELL);
+    
+    // An ask near the mid re-centers the window and evicts the best bid.
+    (void)book.add_order(20, 10, Side::SELL);
+    assert(*book.get_best_bid() == -40);
+    assert(*book.get_best_ask() == 20);
+    assert(book.get_bid_quantity_at_top() == 25);
+    
+    assert(book.cancel_order(first.order_id));
+    assert(book.get_bid_quantity_at_top() == 15);
+    auto taker = book.add_order(-40, 15, Side::SELL);
+    assert(taker.fills.size() == 1);
+    assert(taker.fills[0].buy_order_id == second.order_id);
+    assert(!book.get_best_bid().has_value());
+}
+
+template <typename Book>
+static void check_penny_book(Book& book) {
+    // ITCH prices: $123.45 and $123.46 in 1/10000 dollars.
+    auto bid = book.add_order(1234500, 100, Side::BUY);
+    (void)book.add_order(1234600, 100, Side::SELL);
+    (void)book.add_order(1234700, 100, Side::SELL);
+    assert(bid.order_id != 0);
+    
+    // Sub-penny prices are off-tick and never reach the book.
+    auto off_tick = book.add_order(1234550, 100, Side::BUY);
+    assert(off_tick.order_id == 0);
+    assert(book.get_total_orders() == 3);
+    
+    assert(*book.get_best_bid() == 1234500);
+    assert(*book.get_spread() == itch::kPennyTick);
+    
+    auto taker = book.add_order(1234700, 150, Side::BUY);
+    assert(taker.fills.size() == 2);
+    assert(taker.fills[0].price == 1234600);
+    assert(taker.fills[1].price == 1234700);
+    
+    auto snapshot = book.get_snapshot(5);
+    assert(snapshot.bids.size() == 1);
+    assert(snapshot.bids[0].price == 1234500);
+    assert(snapshot.asks.size() == 1);
+    assert(snapshot.asks[0].price == 1234700);
+    assert(snapshot.asks[0].quantity == 50);
+}
+
+void test_tick_size_normalization() {
+    OrderBook book(itch::kPennyTick);
+    assert(book.tick_size() == itch::kPennyTick);
+    check_penny_book(book);
+    
+    BasicOrderBook<FixedPennyPolicy> fixed;
+    check_penny_book(fixed);
+}
+
+void test_cumulative_depth_and_sweep() {
+    IndexedNarrowBook book;
+    
+    (void)book.add_order(10000, 100, Side::BUY);
+    (void)book.add_order(9990, 200, Side::BUY);
+    (void)book.add_order(9000, 300, Side::BUY);   // outside the 64-tick window
+    (void)book.add_order(10010, 50, Side::SELL);
+    (void)book.add_order(10020, 70, Side::SELL);
+    
+    assert(book.get_bid_depth(10000) == 100);
+    assert(book.get_bid_depth(9995) == 100);
+    assert(book.get_bid_depth(9990) == 300);
+    assert(book.get_bid_depth(0) == 600);
+    assert(book.get_ask_depth(10015) == 50);
+    assert(book.get_ask_depth(20000) == 120);
+    assert(book.get_ask_depth(10000) == 0);
+    
+    auto quote = book.get_bid_sweep(250);
+    assert(quote.quantity == 250);
+    assert(quote.last_price == 9990);
+    assert(quote.notional == 100 * 10000 + 150 * 9990);
+    
+    // Runs past the window into overflow, then out of liquidity.
+    quote = book.get_bid_sweep(1000);
+    assert(quote.quantity == 600);
+    assert(quote.last_price == 9000);
+    assert(quote.notional == 100 * 10000 + 200 * 9990 + 300 * 9000);
+    
+    quote = book.get_ask_sweep(60);
+    assert(quote.last_price == 10020);
+    assert(quote.vwap() == (50.0 * 10010 + 10.0 * 10020) / 60.0);
+    
+    // Fills and modifies keep the index current.
+    (void)book.add_order(10000, 30, Side::SELL);
+    assert(book.modify_order(2, 50));
+    assert(book.get_bid_depth(9990) == 120);
+    assert(book.get_bid_sweep(120).last_price == 9990);
+}
+
+void test_depth_index_matches_level_walk() {
+    // Same flow through an indexed and a walking book, with the market
+    // drifting far enough to re-center the narrow window repeatedly.
+    IndexedNarrowBook indexed;
+    NarrowWindowBook walked;
+    std::uint64_t state = 12345;
+    auto next = [&state] {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return state >> 33;
+    };
+    
+    std::vector<OrderId> live;
+    Price mid = 10000;
+    for (int step = 0; step < 5000; ++step) {
+        mid += static_cast<Price>(next() % 5) - 2;
+        if (live.empty() || next() % 2 == 0) {
+            const Side side = (next() % 2 == 0) ? Side::BUY : Side::SELL;
+            Price price = mid + static_cast<Price>(next() % 80) - 40;
+            if (next() % 40 == 0) {
+                price += (side == Side::BUY) ? -300 : 300;
+            }
+            const Quantity quantity = 1 + next() % 100;
+            const auto a = indexed.add_order(price, quantity, side);
+            const auto b = walked.add_order(price, quantity, side);
+            assert(a.order_id == b.order_id);
+            if (a.remaining_quantity > 0) {
+                live.push_back(a.order_id);
+            }
+        } else {
+            const std::size_t k = next() % live.size();
+            if (next() % 4 == 0) {
+                const Quantity quantity = next() % 120;
+                assert(indexed.modify_order(live[k], quantity) == walked.modify_order(live[k], quantity));
+            } else {
+                assert(indexed.cancel_order(live[k]) == walked.cancel_order(live[k]));
+                live[k] = live.back();
+                live.pop_back();
+            }
+        }
+        
+        const Price probe = mid + static_cast<Price>(next() % 400) - 200;
+        assert(indexed.get_bid_depth(probe) == walked.get_bid_depth(probe));
+        assert(indexed.get_ask_depth(probe) == walked.get_ask_depth(probe));
+        const std::uint64_t quantity = next() % 3000;
+        const auto a = indexed.get_bid_sweep(quantity);
+        const auto b = walked.get_bid_sweep(quantity);
+        assert(a.quantity == b.quantity && a.last_price == b.last_price && a.notional == b.notional);
+        const auto c = indexed.get_ask_sweep(quantity);
+        const auto d = walked.get_ask_sweep(quantity);
+        assert(c.quantity == d.quantity && c.last_price == d.last_price && c.notional == d.notional);
+    }
+}
+
+void test_top_levels_cache() {
+    TopThreeBook book;
+    TopThreeBook::TopSnapshot top;
+    
+    book.get_top_snapshot(top);
+    assert(top.bid_count == 0 && top.ask_count == 0);
+    
+    auto a = book.add_order(10000, 10, Side::BUY);
+    (void)book.add_order(9990, 20, Side::BUY);
+    (void)book.add_order(9980, 30, Side::BUY);
+    (void)book.add_order(9000, 40, Side::BUY);    // fourth level, in overflow
+    (void)book.add_order(10010, 5, Side::SELL);
+    
+    book.get_top_snapshot(top);
+    assert(top.bid_count == 3);
+    assert(top.bids[0].price == 10000 && top.bids[2].price == 9980);
+    assert(top.ask_count == 1 && top.asks[0].quantity == 5);
+    
+    // Volume and order count updates land in place.
+    (void)book.add_order(9990, 5, Side::BUY);
+    assert(book.modify_order(a.order_id, 4));
+    book.get_top_snapshot(top);
+    assert(top.bids[0].quantity == 4);
+    assert(top.bids[1].quantity == 25 && top.bids[1].order_count == 2);
+    
+    // A new best level pushes the third out; emptying levels pulls the
+    // next ones back in from behind the cached run.
+    (void)book.add_order(10005, 1, Side::BUY);
+    book.get_top_snapshot(top);
+    assert(top.bids[0].price == 10005 && top.bids[2].price == 9990);
+    (void)book.add_order(9990, 100, Side::SELL);
+    book.get_top_snapshot(top);
+    assert(top.bid_count == 2);
+    assert(top.bids[0].price == 9980 && top.bids[1].price == 9000);
+    assert(top.ask_count == 2 && top.asks[0].price == 9990 && top.asks[0].quantity == 70);
+    
+    // Shallow snapshots come from the cache and agree with it.
+    auto snapshot = book.get_snapshot(1);
+    assert(snapshot.bids.size() == 1 && snapshot.bids[0].price == 9980);
+    assert(book.get_snapshot(5).bids.size() == 2);
+}
+
+void test_top_level_cache_of_one() {
+    TopOneBook book;
+    TopOneBook::TopSnapshot top;
+    const auto agrees = [&book, &top] {
+        book.get_top_snapshot(top);
+        const auto bid = book.get_best_bid();
+        const auto ask = book.get_best_ask();
+        return top.bid_count == (bid ? 1u : 0u) && top.ask_count == (ask ? 1u : 0u) &&
+               (!bid || top.bids[0].price == *bid) && (!ask || top.asks[0].price == *ask);
+    };
+    
+    auto best = book.add_order(100, 10, Side::BUY);
+    (void)book.add_order(99, 20, Side::BUY);
+    (void)book.add_order(98, 30, Side::BUY);
+    (void)book.add_order(110, 10, Side::SELL);
+    (void)book.add_order(111, 15, Side::SELL);
+    assert(agrees());
+    
+    // Cancelling the only cached level pulls in the next one.
+    assert(book.cancel_order(best.order_id));
+    assert(agrees());
+    assert(top.bids[0].price == 99 && top.bids[0].quantity == 20);
+    assert(book.get_snapshot(1).bids.size() == 1);
+    
+    // So does filling it away, on either side.
+    (void)book.add_order(99, 20, Side::SELL);
+    assert(agrees());
+    assert(top.bids[0].price == 98);
+    (void)book.add_order(110, 10, Side::BUY);
+    assert(agrees());
+    assert(top.asks[0].price == 111 && top.asks[0].quantity == 15);
+    
+    // And an emptied side stays empty.
+    (void)book.add_order(98, 30, Side::SELL);
+    assert(agrees());
+    assert(top.bid_count == 0 && book.get_snapshot(1).bids.empty());
+}
+
 void run_query_tests() {
     std::cout << "[Query Tests]\n";
     RUN_TEST(test_best_bid_ask);
     RUN_TEST(test_spread_and_mid_price);
     RUN_TEST(test_empty_book_returns_nullopt);
     RUN_TEST(test_snapshot);
+    RUN_TEST(test_best_price_across_wide_gaps);
+    RUN_TEST(test_window_recenters_as_market_drifts);
+    RUN_TEST(test_far_orders_kept_outside_window);
+    RUN_TEST(test_best_level_survives_eviction);
+    RUN_TEST(test_tick_size_normalization);
+    RUN_TEST(test_cumulative_depth_and_sweep);
+    RUN_TEST(test_depth_index_matches_level_walk);
+    RUN_TEST(test_top_levels_cache);
+    RUN_TEST(test_top_level_cache_of_one);
     std::cout << "\n";
 }
@@ -5,6 +5,15 @@ void test_best_bid_ask();
 void test_spread_and_mid_price();
 void test_empty_book_returns_nullopt();
 void test_snapshot();
+void test_best_price_across_wide_gaps();
+void test_window_recenters_as_market_drifts();
+void test_far_orders_kept_outside_window();
+void test_best_level_survives_eviction();
+void test_tick_size_normalization();
+void test_cumulative_depth_and_sweep();
+void test_depth_index_matches_level_walk();
+void test_top_levels_cache();
+void test_top_level_cache_of_one();
 
 void run_query_tests();
 